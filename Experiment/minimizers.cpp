@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "parser.h"
+#include "simplifier.h"
+#include "utf8ranges.h"
+#include "regexset.h"
+
+/*
+
+	Minimizer benchmark
+
+	Times Simplifier's minimizers (Hopcroft, Valmari & Lehtinen,
+	Brzozowski) on the DFAs our compilers build : byte DFAs of single
+	patterns (Searcher, ReverseDFA) and of pattern unions (RegexSet,
+	Lexer). For every DFA it prints its size, its density (transitions
+	per state and class used) and the time per run of each minimizer, the
+	numbers Simplifier::ChooseMinimizer is tuned on.
+
+	It has its own main, build it apart from experiment.cpp :
+	g++ -std=c++14 -O2 -I ../HRegex/include minimizers.cpp
+
+*/
+
+typedef Automata (*MinimizerFunction)(const Automata&);
+
+double TimeOf(MinimizerFunction minimize, const Automata& dfa)
+{
+	typedef std::chrono::steady_clock Clock;
+	size_t runs = 0;
+	auto start = Clock::now();
+	auto elapsed = Clock::duration::zero();
+	do
+	{
+		minimize(dfa);
+		++runs;
+		elapsed = Clock::now() - start;
+	} while (elapsed < std::chrono::milliseconds(200));
+	return std::chrono::duration<double, std::micro>(elapsed).count() / runs;
+}
+
+// brzozowski is off for DFAs whose reversal explodes
+void Report(const std::string& name, const Automata& dfa, bool brzozowski = true)
+{
+	// density over the classes some transition is on, as ChooseMinimizer
+	SymbolClasses classes(dfa);
+	std::vector<bool> used(classes.size(), false);
+	size_t transitions = 0;
+	for (State s = 0; s != dfa.size(); ++s)
+	{
+		auto& edges = dfa.getNeighbours(s);
+		for (auto e = edges.begin(); e != edges.end(); ++e)
+		{
+			auto covered = classes.classesOf(e->getTransition());
+			for (auto c = covered.begin(); c != covered.end(); ++c)
+			{
+				used[*c] = true;
+			}
+			transitions += covered.size();
+		}
+	}
+	size_t usedCount = std::count(used.begin(), used.end(), true);
+	double density = static_cast<double>(transitions) / (dfa.size() * usedCount);
+	const char* choices[] = { "hopcroft", "valmari", "brzozowski" };
+	std::cout << std::left << std::setw(28) << name.substr(0, 27) << std::right
+		<< std::setw(8) << dfa.size()
+		<< std::setw(8) << usedCount
+		<< std::setw(8) << std::fixed << std::setprecision(3) << density
+		<< std::setw(12) << std::setprecision(1) << TimeOf(Simplifier::MinimizeDFA, dfa)
+		<< std::setw(12) << TimeOf(Simplifier::ValmariMinimize, dfa);
+	try
+	{
+		if (!brzozowski)
+		{
+			throw IllegalStateError();
+		}
+		std::cout << std::setw(12) << TimeOf(Simplifier::BrzozowskiMinimize, dfa);
+	}
+	catch (IllegalStateError&)
+	{
+		std::cout << std::setw(12) << "-";
+	}
+	std::cout << std::setw(12) << choices[Simplifier::ChooseMinimizer(dfa)] << std::endl;
+}
+
+Automata PatternDFA(const std::string& pattern)
+{
+	Automata nfa;
+	Parser<UTF8>(pattern.c_str(), nfa);
+	nfa = UTF8Ranges::CompileToBytes(nfa);
+	return Simplifier::NFAToDFA(nfa, SymbolClasses(nfa));
+}
+
+Automata UnionDFA(const std::vector<std::string>& patterns)
+{
+	Automata all = RegexSet::Union(patterns);
+	return Simplifier::NFAToDFA(all, SymbolClasses(all));
+}
+
+int main()
+{
+	std::cout << std::left << std::setw(28) << "dfa" << std::right
+		<< std::setw(8) << "states" << std::setw(8) << "classes" << std::setw(8) << "density"
+		<< std::setw(12) << "hopcroft" << std::setw(12) << "valmari" << std::setw(12) << "brzozowski"
+		<< std::setw(12) << "chosen" << "   (us per run)" << std::endl;
+
+	// single patterns, from literal to exploding
+	const char* patterns[] =
+	{
+		"hello world",
+		"\\d+-\\d+-\\d+",
+		"(a|b)*abb",
+		"(a|b)*a(a|b){6}",
+		"(a|b)*a(a|b){10}",
+		".*a.{8}",
+		"(ab|cd|ef)*(\\d\\d|x+){2,5}",
+		"\xe4\xb8\xad(.|\\d)*\xe6\x96\x87",
+		"(a|b|c|d|e|f|g|h)*(abc|bcd|cde){3}",
+		"((a|b)(c|d)*){1,8}",
+		".*(a|b)(a|b|c){5}",
+		".*(a|\\d)(.|a)(a|b){4}",
+	};
+	for (auto p : patterns)
+	{
+		Report(p, PatternDFA(p));
+	}
+
+	// unions : keywords, a lexer like set, many literals
+	std::vector<std::string> keywords = { "if", "else", "while", "for", "return", "break", "continue",
+		"switch", "case", "default", "do", "goto", "struct", "class", "public", "private" };
+	Report("keywords (16)", UnionDFA(keywords));
+	std::vector<std::string> tokens = { "\\d+", "\\d+.\\d+", "(a|b|c|d|e)(a|b|c|d|e|\\d)*", "\\+|-|\\*|/",
+		"==|=|\\(|\\)", "\"(a|b|c| )*\"" };
+	Report("tokens (6)", UnionDFA(tokens));
+	std::vector<std::string> literals;
+	for (int i = 0; i != 200; ++i)
+	{
+		std::string word;
+		for (int x = i * 7919 + 13, j = 0; j != 6; ++j, x = x * 31 + 7)
+		{
+			word += static_cast<char>('a' + (x % 26 + 26) % 26);
+		}
+		literals.push_back(word);
+	}
+	Report("literals (200)", UnionDFA(literals));
+	std::vector<std::string> searches;
+	for (int i = 0; i != 8; ++i)
+	{
+		searches.push_back(".*" + literals[i] + "(\\d|a)*" + literals[i + 8]);
+	}
+	Report("unanchored (8)", UnionDFA(searches));
+
+	// complete DFAs on 32 symbols, of growing size
+	for (size_t n = 500; n <= 8000; n *= 4)
+	{
+		Automata complete;
+		for (size_t s = 0; s != n; ++s)
+		{
+			complete.generateState();
+		}
+		for (size_t s = 0; s != n; ++s)
+		{
+			for (HRegexByte c = 'A'; c != 'A' + 32; ++c)
+			{
+				complete.addTransition(s, (s * 7 + c * 13) % n, c);
+			}
+			if (s % 3 == 0)
+			{
+				complete.setTerminate(s);
+			}
+		}
+		complete.setStart(0);
+		Report("complete " + std::to_string(n), complete, false);
+	}
+}
\ No newline at end of file
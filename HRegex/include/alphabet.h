@@ -0,0 +1,214 @@
+#ifndef _HREG_ALPHABET_
+#define _HREG_ALPHABET_
+
+#include "automata.h"
+
+/*
+
+	Symbol equivalence classes
+
+	Two characters are equivalent when every transition of the automata
+	either accepts both or rejects both. The alphabet is first cut into
+	intervals at every transition endpoint, then intervals covered by
+	exactly the same transitions are merged into one class, which gives
+	the coarsest partition the automata can observe.
+
+	Tables indexed by class stay small : a pattern like \d+x has three
+	classes (digits, 'x', everything else) instead of 0x110000 columns.
+
+*/
+
+class SymbolClasses
+{
+public:
+	// a single class holding every character
+	SymbolClasses()
+	{
+		boundaries.push_back(0);
+		intervalClass.push_back(0);
+		representatives.push_back(0);
+		std::fill(byteClasses, byteClasses + 256, 0);
+	}
+
+	SymbolClasses(const Automata& automata)
+	{
+		// distinct transitions, described by the intervals they cover
+		std::map<std::vector<Range>, size_t, RangeLess> labels;
+		std::vector<std::vector<Range>> coverage;
+		boundaries.push_back(0);
+		for (State s = 0; s != automata.size(); ++s)
+		{
+			auto& edges = automata.getNeighbours(s);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				Transition t = e->getTransition();
+				if (t.getType() == Transition::EPSILON ||
+					t.getType() == Transition::WILDCARD)
+				{
+					// covers every class, never splits one
+					continue;
+				}
+				auto intervals = intervalsOf(t);
+				if (labels.find(intervals) != labels.end())
+				{
+					continue;
+				}
+				labels[intervals] = coverage.size();
+				coverage.push_back(intervals);
+				for (auto r = intervals.begin(); r != intervals.end(); ++r)
+				{
+					boundaries.push_back(r->lower);
+					if (r->upper != UINT32_MAX)
+					{
+						boundaries.push_back(r->upper + 1);
+					}
+				}
+			}
+		}
+		std::sort(boundaries.begin(), boundaries.end());
+		boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+		// signature of an interval : the transitions covering it
+		std::vector<std::vector<size_t>> signatures(boundaries.size());
+		for (size_t label = 0; label != coverage.size(); ++label)
+		{
+			for (auto r = coverage[label].begin(); r != coverage[label].end(); ++r)
+			{
+				for (size_t i = intervalOf(r->lower); i <= intervalOf(r->upper); ++i)
+				{
+					signatures[i].push_back(label);
+				}
+			}
+		}
+		std::map<std::vector<size_t>, uint32_t> signatureToClass;
+		intervalClass.resize(boundaries.size());
+		for (size_t i = 0; i != boundaries.size(); ++i)
+		{
+			auto result = signatureToClass.find(signatures[i]);
+			if (result != signatureToClass.end())
+			{
+				intervalClass[i] = result->second;
+			}
+			else
+			{
+				uint32_t cls = static_cast<uint32_t>(representatives.size());
+				signatureToClass[signatures[i]] = cls;
+				intervalClass[i] = cls;
+				representatives.push_back(boundaries[i]);
+			}
+		}
+		for (UnicodeChar ch = 0; ch != 256; ++ch)
+		{
+			byteClasses[ch] = intervalClass[intervalOf(ch)];
+		}
+	}
+
+	// number of classes
+	size_t size() const
+	{
+		return representatives.size();
+	}
+
+	size_t classOf(UnicodeChar ch) const
+	{
+		if (ch < 256)
+		{
+			return byteClasses[ch];
+		}
+		return intervalClass[intervalOf(ch)];
+	}
+
+	// the smallest character of a class
+	UnicodeChar representative(size_t cls) const
+	{
+		return representatives[cls];
+	}
+
+	// all characters of a class
+	RangeSet getRangeSet(size_t cls) const
+	{
+		RangeSet st;
+		for (size_t i = 0; i != boundaries.size(); ++i)
+		{
+			if (intervalClass[i] == cls)
+			{
+				UnicodeChar upper = (i + 1 == boundaries.size()) ? UINT32_MAX : boundaries[i + 1] - 1;
+				st.insert({ boundaries[i], upper });
+			}
+		}
+		return st;
+	}
+
+	// classes accepted by a transition of the automata the classes were
+	// computed from (sorted, such a transition never covers part of a class)
+	std::vector<size_t> classesOf(const Transition& t) const
+	{
+		std::vector<size_t> result;
+		switch (t.getType())
+		{
+		case Transition::EPSILON:
+			break;
+		case Transition::NORMAL:
+			result.push_back(classOf(t.getMatch()));
+			break;
+		case Transition::WILDCARD:
+			for (size_t c = 0; c != size(); ++c)
+			{
+				result.push_back(c);
+			}
+			break;
+		case Transition::RANGE:
+			for (auto r = t.getRangeSet().begin(); r != t.getRangeSet().end(); ++r)
+			{
+				for (size_t i = intervalOf(r->lower); i <= intervalOf(r->upper); ++i)
+				{
+					result.push_back(intervalClass[i]);
+				}
+			}
+			std::sort(result.begin(), result.end());
+			result.erase(std::unique(result.begin(), result.end()), result.end());
+			break;
+		}
+		return result;
+	}
+
+private:
+	struct RangeLess
+	{
+		bool operator()(const std::vector<Range>& a, const std::vector<Range>& b) const
+		{
+			return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+				[](const Range& x, const Range& y)
+			{
+				return x.lower < y.lower || (x.lower == y.lower && x.upper < y.upper);
+			});
+		}
+	};
+
+	static std::vector<Range> intervalsOf(const Transition& t)
+	{
+		std::vector<Range> intervals;
+		if (t.getType() == Transition::NORMAL)
+		{
+			intervals.push_back({ t.getMatch(), t.getMatch() });
+		}
+		else if (t.getType() == Transition::RANGE)
+		{
+			intervals.assign(t.getRangeSet().begin(), t.getRangeSet().end());
+		}
+		return intervals;
+	}
+
+	size_t intervalOf(UnicodeChar ch) const
+	{
+		return std::upper_bound(boundaries.begin(), boundaries.end(), ch) - boundaries.begin() - 1;
+	}
+
+	// start of each interval, ascending, boundaries[0] == 0
+	std::vector<UnicodeChar> boundaries;
+	std::vector<uint32_t> intervalClass;
+	std::vector<UnicodeChar> representatives;
+	uint32_t byteClasses[256];
+};
+
+#endif
\ No newline at end of file
@@ -9,6 +9,7 @@
 
 */
 
+#include <type_traits>
 #include "globals.h"
 #include "encoding.h"
 #include "containers.h"
@@ -19,7 +20,7 @@ struct Range
 	UnicodeChar upper;
 	bool operator==(const Range& other) const
 	{
-		return lower == lower && upper == upper;
+		return lower == other.lower && upper == other.upper;
 	}
 };
 
@@ -69,16 +70,22 @@ public:
 	};
 
 	Transition(UnicodeChar m)
-		: type(NORMAL)
+		: type(NORMAL), tag(-1)
 	{ 
 		data.match = m; 
 	}
 	Transition(const RangeSet& st)
-		: type(RANGE), rangeSet(st)
+		: type(RANGE), tag(-1), rangeSet(st)
 	{
 	}
 	Transition(TransitionType tp)
-		: type(tp)
+		: type(tp), tag(-1)
+	{
+	}
+	// epsilon transition recording the position it is taken at in
+	// capture slot t (ignored by everything but capture engines)
+	Transition(TransitionType tp, int t)
+		: type(tp), tag(t)
 	{
 	}
 
@@ -103,6 +110,22 @@ public:
 		return type;
 	}
 
+	UnicodeChar getMatch() const
+	{
+		return data.match;
+	}
+
+	const RangeSet& getRangeSet() const
+	{
+		return rangeSet;
+	}
+
+	// capture slot, -1 if none
+	int getTag() const
+	{
+		return tag;
+	}
+
 	bool operator==(const Transition& other) const
 	{
 		if (other.type != type)
@@ -132,6 +155,11 @@ public:
 			ss << "Normal" << "[" << data.match << "]";
 			return ss.str();
 		case Transition::EPSILON:
+			if (tag >= 0)
+			{
+				ss << "Episilon" << "[tag " << tag << "]";
+				return ss.str();
+			}
 			return std::string("Episilon");
 		case Transition::WILDCARD:
 			return std::string("Wildcard");
@@ -150,6 +178,7 @@ public:
 
 private:
 	TransitionType type;
+	int tag;
 	union u
 	{
 		UnicodeChar match;
@@ -174,7 +203,7 @@ public:
 	{
 		return to;
 	}
-	Transition getTransition() const
+	const Transition& getTransition() const
 	{
 		return transition;
 	}
@@ -202,6 +231,7 @@ public:
 		adj.clear();
 		start.clear();
 		terminate.clear();
+		labels.clear();
 	}
 
 	State generateState()
@@ -233,6 +263,42 @@ public:
 		terminate.insert(s);
 	}
 
+	// a terminate state can carry labels (the id of the pattern it
+	// accepts for example), determinization and minimization keep them
+	void setTerminate(State s, size_t label)
+	{
+		setTerminate(s);
+		labels[s].insert(label);
+	}
+
+	SortedVectorSet<size_t> getLabels(State s) const
+	{
+		auto result = labels.find(s);
+		if (result == labels.end())
+		{
+			return SortedVectorSet<size_t>();
+		}
+		return result->second;
+	}
+
+	// union of the labels of a set of states (a SortedVectorSet<State>
+	// or a DenseBitSet)
+	template <typename StateSet>
+	typename std::enable_if<!std::is_integral<StateSet>::value, SortedVectorSet<size_t>>::type
+	getLabels(const StateSet& states) const
+	{
+		SortedVectorSet<size_t> result;
+		for (auto i = states.begin(); i != states.end(); ++i)
+		{
+			auto found = labels.find(*i);
+			if (found != labels.end())
+			{
+				result = result || found->second;
+			}
+		}
+		return result;
+	}
+
 	const std::vector<Edge>& getNeighbours(State s) const
 	{
 		if (s > adj.size())
@@ -252,12 +318,12 @@ public:
 		return ret;
 	}
 
-	SortedVectorSet<State> getStart() const
+	const SortedVectorSet<State>& getStart() const
 	{
 		return start;
 	}
 
-	SortedVectorSet<State> getTerminate() const
+	const SortedVectorSet<State>& getTerminate() const
 	{
 		return terminate;
 	}
@@ -285,7 +351,8 @@ public:
 		return terminate.contains(s);
 	}
 
-	bool containsTerminate(const SortedVectorSet<State>& s) const
+	template <typename StateSet>
+	bool containsTerminate(const StateSet& s) const
 	{
 		return std::find_if(s.begin(), s.end(), [&](State st)
 		{
@@ -293,14 +360,15 @@ public:
 		}) != s.end();
 	}
 
-	std::vector<Transition> getNoneEpsilonTransitions(const SortedVectorSet<State>& states) const
+	template <typename StateSet>
+	std::vector<Transition> getNoneEpsilonTransitions(const StateSet& states) const
 	{
 		std::vector<Transition> transitions;
 		for (auto i = states.begin(); i != states.end(); ++i)
 		{
 			for (auto j = getNeighbours(*i).begin(); j != getNeighbours(*i).end(); ++j)
 			{
-				Transition t = j->getTransition();
+				const Transition& t = j->getTransition();
 				if (t.getType() == Transition::EPSILON)
 				{
 					continue;
@@ -314,38 +382,84 @@ public:
 		return transitions;
 	}
 
-	SortedVectorSet<State> epsilonClosure(const SortedVectorSet<State>& states) const
+	// disjoint intervals covering the characters accepted by the
+	// non-epsilon transitions of states, in ascending order : every
+	// character of an interval is accepted by the same transitions
+	template <typename StateSet>
+	std::vector<Range> getAtoms(const StateSet& states) const
 	{
-		// use DFS to find eps-closure
-		std::vector<bool> mark(size(), false);
-		std::stack<State> stk;
-		SortedVectorSet<State> epsilon = states;
-		for (auto i = states.begin(); i != states.end(); ++i)
+		// +1 where an interval starts, -1 after it ends (may be 2^32)
+		std::vector<std::pair<uint64_t, int>> events;
+		auto add = [&](UnicodeChar lower, UnicodeChar upper)
 		{
-			mark[*i] = true;
-			stk.push(*i);
-		}
-		while (!stk.empty())
+			events.push_back(std::make_pair(static_cast<uint64_t>(lower), 1));
+			events.push_back(std::make_pair(static_cast<uint64_t>(upper) + 1, -1));
+		};
+		for (auto i = states.begin(); i != states.end(); ++i)
 		{
-			State s = stk.top();
-			stk.pop();
-			for (auto i = getNeighbours(s).begin(); i != getNeighbours(s).end(); ++i)
+			for (auto j = getNeighbours(*i).begin(); j != getNeighbours(*i).end(); ++j)
 			{
-				State foo = i->getTo();
-				if (!mark[foo] && i->getTransition().getType() == Transition::EPSILON)
+				const Transition& t = j->getTransition();
+				switch (t.getType())
 				{
-					epsilon.insert(foo);
-					mark[foo] = true;
-					stk.push(foo);
+				case Transition::NORMAL:
+					add(t.getMatch(), t.getMatch());
+					break;
+				case Transition::WILDCARD:
+					add(0, UINT32_MAX);
+					break;
+				case Transition::RANGE:
+					for (auto r = t.getRangeSet().begin(); r != t.getRangeSet().end(); ++r)
+					{
+						add(r->lower, r->upper);
+					}
+					break;
+				default:
+					break;
 				}
 			}
 		}
-		return epsilon;
+		std::sort(events.begin(), events.end());
+		std::vector<Range> atoms;
+		int depth = 0;
+		for (size_t i = 0; i != events.size(); )
+		{
+			uint64_t position = events[i].first;
+			while (i != events.size() && events[i].first == position)
+			{
+				depth += events[i++].second;
+			}
+			if (depth > 0)
+			{
+				// an interval is still open, so there is a next event
+				atoms.push_back({ static_cast<UnicodeChar>(position),
+					static_cast<UnicodeChar>(events[i].first - 1) });
+			}
+		}
+		return atoms;
+	}
+
+	// a search over the whole automata, allocating per call : it is the
+	// reference the precomputed closures are checked against, see
+	// EpsilonClosures to compute many closures
+	template <typename StateSet>
+	StateSet epsilonClosure(const StateSet& states) const
+	{
+		SparseSet reached(size());
+		std::vector<State> stk;
+		for (auto i = states.begin(); i != states.end(); ++i)
+		{
+			addClosure(reached, *i, stk);
+		}
+		std::vector<State> sorted(reached.begin(), reached.end());
+		std::sort(sorted.begin(), sorted.end());
+		return StateSet(sorted.begin(), sorted.end());
 	}
 
-	SortedVectorSet<State> move(const SortedVectorSet<State>& states, Transition t) const
+	template <typename StateSet>
+	StateSet move(const StateSet& states, Transition t) const
 	{
-		SortedVectorSet<State> destinations;
+		StateSet destinations;
 
 		// !!! IGNORE EPSILON TRANSITIONS
 
@@ -365,14 +479,15 @@ public:
 		return destinations;
 	}
 
-	SortedVectorSet<State> move(const SortedVectorSet<State>& states, UnicodeChar input) const
+	template <typename StateSet>
+	StateSet move(const StateSet& states, UnicodeChar input) const
 	{
-		SortedVectorSet<State> destinations;
+		StateSet destinations;
 		for (auto i = states.begin(); i != states.end(); ++i)
 		{
 			for (auto j = getNeighbours(*i).begin(); j != getNeighbours(*i).end(); ++j)
 			{
-				Transition t = j->getTransition();
+				const Transition& t = j->getTransition();
 				if (t.getType() != Transition::EPSILON &&
 					t.check(input))
 				{
@@ -402,16 +517,46 @@ public:
 		return ret;
 	}
 
+	// the state sets and the stack are allocated once per call, nothing
+	// is allocated per character, closures are searched as they are met
+	// ! NOTE : this is the slow reference path, kept independent of the
+	//          precomputed closures it checks in the tests ; building
+	//          them costs more than one run, see NFASimulator to match
+	//          an automata many times
 	template <EncodeType E>
 	bool simulate(typename Encode<E>::PointerType str, size_t length) const
 	{
 		StreamReader<E> reader(str);
-		SortedVectorSet<State> states = getStart();
-		for (size_t i = 0; i < length; ++i)
+		SparseSet current(size());
+		SparseSet next(size());
+		std::vector<State> stk;
+		stk.reserve(size());
+		for (auto i = start.begin(); i != start.end(); ++i)
 		{
-			states = move(epsilonClosure(states), reader.next());
+			addClosure(current, *i, stk);
 		}
-		return containsTerminate(epsilonClosure(states));
+		for (size_t i = 0; i < length && !current.isEmpty(); ++i)
+		{
+			UnicodeChar ch = reader.next();
+			next.clear();
+			for (auto s = current.begin(); s != current.end(); ++s)
+			{
+				auto& edges = adj[*s];
+				for (auto e = edges.begin(); e != edges.end(); ++e)
+				{
+					const Transition& t = e->getTransition();
+					if (t.getType() != Transition::EPSILON && t.check(ch))
+					{
+						addClosure(next, e->getTo(), stk);
+					}
+				}
+			}
+			current.swap(next);
+		}
+		return std::find_if(current.begin(), current.end(), [&](size_t s)
+		{
+			return terminate.contains(s);
+		}) != current.end();
 	}
 
 	std::string toString() const
@@ -441,9 +586,179 @@ public:
 	}
 
 private:
+	// add s and the states reachable from it by epsilon transitions
+	void addClosure(SparseSet& states, State s, std::vector<State>& stk) const
+	{
+		if (!states.insert(s))
+		{
+			return;
+		}
+		stk.push_back(s);
+		while (!stk.empty())
+		{
+			State current = stk.back();
+			stk.pop_back();
+			auto& edges = adj[current];
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				if (e->getTransition().getType() == Transition::EPSILON && states.insert(e->getTo()))
+				{
+					stk.push_back(e->getTo());
+				}
+			}
+		}
+	}
+
 	SortedVectorSet<State> start;
 	SortedVectorSet<State> terminate;
+	std::map<State, SortedVectorSet<size_t>> labels;
 	std::vector<std::vector<Edge>> adj;
 };
 
+// the epsilon closure of every state of an automata, computed once and
+// kept as sorted arrays sharing one buffer : the closure of a set of
+// states is the merge of the closures of its states, no search is
+// repeated (see Simplifier::NFAToDFA)
+// the closure of a DenseBitSet is the union, word by word, of the
+// closures of its states as bit rows, which are built on first use
+// (n * n / 8 bytes, DenseBitSets are meant for small automata)
+// states or edges added to the automata afterwards are not seen
+// with IMPORTANT_STATES a closure only keeps the states that consume
+// input or accept, which is all a simulation needs (see NFASimulator)
+//
+// ! NOTE : merging reuses a scratch set, an EpsilonClosures must not be
+//          shared between threads
+class EpsilonClosures
+{
+public:
+	enum Keep
+	{
+		ALL_STATES,
+		IMPORTANT_STATES
+	};
+
+	EpsilonClosures(const Automata& automata, Keep keep = ALL_STATES)
+		: seen(automata.size())
+	{
+		std::vector<bool> kept(automata.size(), true);
+		if (keep == IMPORTANT_STATES)
+		{
+			for (State s = 0; s != automata.size(); ++s)
+			{
+				auto& edges = automata.getNeighbours(s);
+				kept[s] = automata.isTerminate(s) ||
+					std::find_if(edges.begin(), edges.end(), [](const Edge& e)
+				{
+					return e.getTransition().getType() != Transition::EPSILON;
+				}) != edges.end();
+			}
+		}
+		std::vector<State> stk;
+		closureStart.push_back(0);
+		for (State s = 0; s != automata.size(); ++s)
+		{
+			seen.clear();
+			seen.insert(s);
+			stk.push_back(s);
+			while (!stk.empty())
+			{
+				State current = stk.back();
+				stk.pop_back();
+				auto& edges = automata.getNeighbours(current);
+				for (auto e = edges.begin(); e != edges.end(); ++e)
+				{
+					if (e->getTransition().getType() == Transition::EPSILON && seen.insert(e->getTo()))
+					{
+						stk.push_back(e->getTo());
+					}
+				}
+			}
+			for (auto t = seen.begin(); t != seen.end(); ++t)
+			{
+				if (kept[*t])
+				{
+					closures.push_back(*t);
+				}
+			}
+			std::sort(closures.begin() + closureStart.back(), closures.end());
+			closureStart.push_back(closures.size());
+		}
+	}
+
+	// the closure of state s, sorted, without building a set
+	std::vector<State>::const_iterator begin(State s) const
+	{
+		return closures.begin() + closureStart[s];
+	}
+
+	std::vector<State>::const_iterator end(State s) const
+	{
+		return closures.begin() + closureStart[s + 1];
+	}
+
+	SortedVectorSet<State> closure(State s) const
+	{
+		return SortedVectorSet<State>(closures.begin() + closureStart[s], closures.begin() + closureStart[s + 1]);
+	}
+
+	SortedVectorSet<State> closure(const SortedVectorSet<State>& states) const
+	{
+		if (states.size() == 1)
+		{
+			return closure(*states.begin());
+		}
+		seen.clear();
+		merged.clear();
+		for (auto s = states.begin(); s != states.end(); ++s)
+		{
+			for (size_t i = closureStart[*s]; i != closureStart[*s + 1]; ++i)
+			{
+				if (seen.insert(closures[i]))
+				{
+					merged.push_back(closures[i]);
+				}
+			}
+		}
+		std::sort(merged.begin(), merged.end());
+		return SortedVectorSet<State>(merged.begin(), merged.end());
+	}
+
+	DenseBitSet closure(const DenseBitSet& states) const
+	{
+		size_t n = closureStart.size() - 1;
+		if (rows.size() != n)
+		{
+			rows.assign(n, DenseBitSet(n));
+			for (State s = 0; s != n; ++s)
+			{
+				for (size_t i = closureStart[s]; i != closureStart[s + 1]; ++i)
+				{
+					rows[s].insert(closures[i]);
+				}
+			}
+		}
+		DenseBitSet result(n);
+		for (auto s = states.begin(); s != states.end(); ++s)
+		{
+			result |= rows[*s];
+		}
+		return result;
+	}
+
+	// number of states kept, all closures together
+	size_t getClosureSize() const
+	{
+		return closures.size();
+	}
+
+private:
+	// closure of state s is closures[closureStart[s], closureStart[s + 1])
+	std::vector<size_t> closureStart;
+	std::vector<State> closures;
+	mutable SparseSet seen;
+	mutable std::vector<State> merged;
+	// closure of state s as bits, empty until a DenseBitSet is closed
+	mutable std::vector<DenseBitSet> rows;
+};
+
 #endif
\ No newline at end of file
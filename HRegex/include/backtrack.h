@@ -0,0 +1,169 @@
+#ifndef _HREG_BACKTRACK_
+#define _HREG_BACKTRACK_
+
+#include "parser.h"
+#include "utf8ranges.h"
+
+/*
+
+	Bounded backtracker
+
+	Explores the byte NFA depth first, in edge order, like a classic
+	backtracking matcher, so the first path reaching the terminate state
+	is the leftmost-first match (the same one PikeVM finds). Every
+	(state, position) pair is visited at most once : whether a match can
+	be reached from it does not depend on the path that led there, so a
+	pair that failed once fails again. This keeps the search linear, but
+	needs one bit per pair, which is why it is only worth it for short
+	inputs : the bitset is bounded by MAX_VISITED_BITS and a longer text
+	must be given to another engine (see getMaxLength).
+
+	For a few hundred bytes it has none of the per-step thread list
+	copies of PikeVM, nor the state construction of a DFA.
+
+	! NOTE : the bitset and the stack are reused by every search, a
+	         BoundedBacktracker must not be shared between threads
+
+*/
+
+class BoundedBacktracker
+{
+public:
+	enum : size_t { NONE = SIZE_MAX };
+
+	static const size_t MAX_VISITED_BITS = 256 * 1024;
+
+	BoundedBacktracker(const char* pattern)
+	{
+		Automata codepoints;
+		Parser<UTF8> parser(pattern, codepoints);
+		nfa = UTF8Ranges::CompileToBytes(codepoints);
+		slotCount = 2 * (parser.getCaptureCount() + 1);
+		slots.resize(slotCount);
+	}
+
+	// number of groups, including group 0
+	size_t getGroupCount() const
+	{
+		return slotCount / 2;
+	}
+
+	// longest text (from the start offset on) a search accepts
+	size_t getMaxLength() const
+	{
+		size_t states = std::max<size_t>(nfa.size(), 1);
+		return states < MAX_VISITED_BITS ? MAX_VISITED_BITS / states - 1 : 0;
+	}
+
+	// leftmost-first match in text[from, length), captures like PikeVM
+	// throw IllegalStateError when length - from > getMaxLength()
+	bool find(const char* text, size_t length, std::vector<size_t>& captures, size_t from = 0)
+	{
+		return run(reinterpret_cast<const HRegexByte*>(text), length, from, false, captures);
+	}
+
+	// whether the whole text matches, with the captures of that match
+	bool match(const char* text, size_t length, std::vector<size_t>& captures)
+	{
+		return run(reinterpret_cast<const HRegexByte*>(text), length, 0, true, captures);
+	}
+
+private:
+	// a state to visit at a position, or a slot value to put back
+	struct Job
+	{
+		State state;
+		size_t position;
+		int tag;
+		size_t restore;
+		bool isRestore;
+	};
+
+	bool run(const HRegexByte* str, size_t length, size_t from, bool anchored,
+		std::vector<size_t>& captures)
+	{
+		if (nfa.size() == 0 || from > length)
+		{
+			return false;
+		}
+		if (length - from > getMaxLength())
+		{
+			throw IllegalStateError();
+		}
+		size_t columns = length - from + 1;
+		visited.assign((nfa.size() * columns + 63) / 64, 0);
+		State start = nfa.getStart().last();
+		for (size_t pos = from; pos <= length; ++pos)
+		{
+			std::fill(slots.begin(), slots.end(), NONE);
+			slots[0] = pos;
+			if (step(str, length, from, start, pos, anchored))
+			{
+				captures.assign(slots.begin(), slots.end());
+				return true;
+			}
+			if (anchored)
+			{
+				break;
+			}
+		}
+		return false;
+	}
+
+	// depth first search from (s, pos), true with slots filled on a match
+	bool step(const HRegexByte* str, size_t length, size_t from, State s, size_t pos, bool anchored)
+	{
+		size_t columns = length - from + 1;
+		stk.clear();
+		stk.push_back({ s, pos, -1, 0, false });
+		while (!stk.empty())
+		{
+			Job job = stk.back();
+			stk.pop_back();
+			if (job.isRestore)
+			{
+				slots[job.tag] = job.restore;
+				continue;
+			}
+			size_t bit = job.state * columns + (job.position - from);
+			if (visited[bit / 64] & (static_cast<uint64_t>(1) << (bit % 64)))
+			{
+				continue;
+			}
+			visited[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+			if (job.tag >= 0)
+			{
+				// entering a tagged edge
+				stk.push_back({ 0, 0, job.tag, slots[job.tag], true });
+				slots[job.tag] = job.position;
+			}
+			if (nfa.isTerminate(job.state) && (!anchored || job.position == length))
+			{
+				slots[1] = job.position;
+				return true;
+			}
+			auto& edges = nfa.getNeighbours(job.state);
+			for (auto e = edges.rbegin(); e != edges.rend(); ++e)
+			{
+				const Transition& t = e->getTransition();
+				if (t.getType() == Transition::EPSILON)
+				{
+					stk.push_back({ e->getTo(), job.position, t.getTag(), 0, false });
+				}
+				else if (job.position < length && t.check(str[job.position]))
+				{
+					stk.push_back({ e->getTo(), job.position + 1, -1, 0, false });
+				}
+			}
+		}
+		return false;
+	}
+
+	Automata nfa;
+	size_t slotCount;
+	std::vector<size_t> slots;
+	std::vector<uint64_t> visited;
+	std::vector<Job> stk;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,289 @@
+#ifndef _HREG_BITNFA_
+#define _HREG_BITNFA_
+
+#include "parser.h"
+#include "utf8ranges.h"
+#include "alphabet.h"
+
+/*
+
+	Bit-parallel NFA
+
+	Simulates the Glushkov automata of a pattern (see PositionBuilder)
+	with the set of active states held in a bitset, generalising
+	Shift-And : in a position automata every edge entering a state has
+	the same label, so a step is
+
+		D' = Follow(D) & B[class of the byte]
+
+	where B[c] is the set of positions entered by class c. Follow(D) is
+	the union of the follow sets of the active positions, read from
+	tables indexed by 8 bits of D at a time (Navarro & Raffinot), so a
+	step costs a few table lookups per word whatever the number of
+	active states. The byte automata is made homogeneous first : a state
+	entered by several byte ranges (UTF-8 sequences) is split into one
+	position per set of symbol classes entering it.
+
+	Up to 64 positions the bitset is a single register, beyond that it
+	is a row of words : every operation is a loop over contiguous words
+	the compiler can vectorize. A pattern needs no more than
+	MAX_POSITIONS positions, the tables grow with the square of it.
+
+	The time per byte does not depend on the pattern's DFA, which makes
+	it a fit for patterns whose DFA explodes ((a|b)*a(a|b){80}).
+
+	! NOTE : the state bitsets are reused by every run, a BitParallelNFA
+	         must not be shared between threads
+
+*/
+
+class BitParallelNFA
+{
+public:
+	static const size_t MAX_POSITIONS = 512;
+
+	// throw TooManyStatesError when more than MAX_POSITIONS are needed
+	BitParallelNFA(const char* pattern)
+		: positions(0), words(1)
+	{
+		Automata codepoints;
+		Parser<UTF8>(pattern, codepoints, GLUSHKOV);
+		Automata bytes = UTF8Ranges::CompileToBytes(codepoints);
+		classes = SymbolClasses(bytes);
+		if (bytes.size() != 0)
+		{
+			build(bytes);
+		}
+	}
+
+	// number of positions (bits) of the homogeneous automata
+	size_t getPositionCount() const
+	{
+		return positions;
+	}
+
+	// whether the whole text matches
+	bool match(const char* text, size_t length)
+	{
+		return run(reinterpret_cast<const HRegexByte*>(text), length, true);
+	}
+
+	// whether a match ends somewhere in the text
+	bool isMatch(const char* text, size_t length)
+	{
+		return run(reinterpret_cast<const HRegexByte*>(text), length, false);
+	}
+
+private:
+	bool run(const HRegexByte* str, size_t length, bool anchored)
+	{
+		if (positions == 0)
+		{
+			return false;
+		}
+		if (words == 1)
+		{
+			return runSingle(str, length, anchored);
+		}
+		std::copy(startMask.begin(), startMask.end(), current.begin());
+		if (!anchored && intersects(current.data(), acceptMask.data()))
+		{
+			return true;
+		}
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (!anchored)
+			{
+				for (size_t w = 0; w != words; ++w)
+				{
+					current[w] |= startMask[w];
+				}
+			}
+			step(current.data(), next.data(), classes.classOf(str[i]));
+			std::swap(current, next);
+			if (!anchored && intersects(current.data(), acceptMask.data()))
+			{
+				return true;
+			}
+		}
+		return intersects(current.data(), acceptMask.data());
+	}
+
+	// the same with the bitset in a register
+	bool runSingle(const HRegexByte* str, size_t length, bool anchored) const
+	{
+		uint64_t start = startMask[0];
+		uint64_t accept = acceptMask[0];
+		uint64_t d = start;
+		if (!anchored && (d & accept) != 0)
+		{
+			return true;
+		}
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (!anchored)
+			{
+				d |= start;
+			}
+			uint64_t reached = 0;
+			for (size_t chunk = 0; d != 0; ++chunk, d >>= 8)
+			{
+				reached |= follow[(chunk << 8) | (d & 0xff)];
+			}
+			d = reached & entered[classes.classOf(str[i])];
+			if (!anchored && (d & accept) != 0)
+			{
+				return true;
+			}
+		}
+		return (d & accept) != 0;
+	}
+
+	void step(const uint64_t* d, uint64_t* out, size_t cls) const
+	{
+		std::fill(out, out + words, 0);
+		for (size_t w = 0; w != words; ++w)
+		{
+			uint64_t word = d[w];
+			for (size_t chunk = w * 8; word != 0; ++chunk, word >>= 8)
+			{
+				if ((word & 0xff) == 0)
+				{
+					continue;
+				}
+				const uint64_t* row = &follow[((chunk << 8) | (word & 0xff)) * words];
+				for (size_t j = 0; j != words; ++j)
+				{
+					out[j] |= row[j];
+				}
+			}
+		}
+		const uint64_t* mask = &entered[cls * words];
+		for (size_t j = 0; j != words; ++j)
+		{
+			out[j] &= mask[j];
+		}
+	}
+
+	bool intersects(const uint64_t* a, const uint64_t* b) const
+	{
+		for (size_t j = 0; j != words; ++j)
+		{
+			if ((a[j] & b[j]) != 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void setBit(uint64_t* row, size_t bit)
+	{
+		row[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+	}
+
+	void build(const Automata& bytes)
+	{
+		// a position is a state of the byte automata together with the
+		// classes entering it, start states are entered by none
+		typedef std::pair<State, std::vector<size_t>> Position;
+		std::map<Position, size_t> ids;
+		std::vector<Position> order;
+		auto intern = [&](const Position& p) -> size_t
+		{
+			auto found = ids.find(p);
+			if (found != ids.end())
+			{
+				return found->second;
+			}
+			if (order.size() == MAX_POSITIONS)
+			{
+				throw TooManyStatesError();
+			}
+			ids[p] = order.size();
+			order.push_back(p);
+			return order.size() - 1;
+		};
+		auto starts = bytes.getStart();
+		std::vector<size_t> startIds;
+		for (auto s = starts.begin(); s != starts.end(); ++s)
+		{
+			startIds.push_back(intern(Position(*s, std::vector<size_t>())));
+		}
+		// follow sets, by position id
+		std::vector<std::vector<size_t>> successors;
+		for (size_t i = 0; i != order.size(); ++i)
+		{
+			successors.push_back(std::vector<size_t>());
+			auto& edges = bytes.getNeighbours(order[i].first);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				size_t next = intern(Position(e->getTo(), classes.classesOf(e->getTransition())));
+				successors[i].push_back(next);
+			}
+		}
+		positions = order.size();
+		words = (positions + 63) / 64;
+		size_t chunks = words * 8;
+		startMask.assign(words, 0);
+		acceptMask.assign(words, 0);
+		entered.assign(classes.size() * words, 0);
+		follow.assign(chunks * 256 * words, 0);
+		current.assign(words, 0);
+		next.assign(words, 0);
+		for (auto i = startIds.begin(); i != startIds.end(); ++i)
+		{
+			setBit(startMask.data(), *i);
+		}
+		for (size_t i = 0; i != positions; ++i)
+		{
+			if (bytes.isTerminate(order[i].first))
+			{
+				setBit(acceptMask.data(), i);
+			}
+			auto& entering = order[i].second;
+			for (auto c = entering.begin(); c != entering.end(); ++c)
+			{
+				setBit(&entered[*c * words], i);
+			}
+		}
+		// follow[chunk][v] is the union of the follow sets of the bits of
+		// v, filled from the entry without the lowest bit of v
+		for (size_t chunk = 0; chunk != chunks; ++chunk)
+		{
+			for (size_t v = 1; v != 256; ++v)
+			{
+				size_t low = 0;
+				while (((v >> low) & 1) == 0)
+				{
+					++low;
+				}
+				uint64_t* row = &follow[((chunk << 8) | v) * words];
+				const uint64_t* rest = &follow[((chunk << 8) | (v & (v - 1))) * words];
+				std::copy(rest, rest + words, row);
+				size_t position = chunk * 8 + low;
+				if (position < positions)
+				{
+					for (auto s = successors[position].begin(); s != successors[position].end(); ++s)
+					{
+						setBit(row, *s);
+					}
+				}
+			}
+		}
+	}
+
+	SymbolClasses classes;
+	size_t positions;
+	size_t words;
+	std::vector<uint64_t> startMask;
+	std::vector<uint64_t> acceptMask;
+	// B[class], words per class
+	std::vector<uint64_t> entered;
+	// Follow tables, words per (chunk, 8 bits) entry
+	std::vector<uint64_t> follow;
+	std::vector<uint64_t> current;
+	std::vector<uint64_t> next;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef _HREG_CAPTURE_
+#define _HREG_CAPTURE_
+
+#include "onepass.h"
+#include "backtrack.h"
+#include "pikevm.h"
+
+/*
+
+	Capture matcher
+
+	Extracts captures with the cheapest engine that can handle a call :
+
+	- OnePassDFA for a full match, when the pattern is one-pass,
+	- BoundedBacktracker when states x length fits its bitset, which is
+	  the case for short texts (identifiers, headers),
+	- PikeVM otherwise.
+
+	All three agree on the captures (leftmost-first), the choice is only
+	about speed.
+
+	! NOTE : the engines keep scratch buffers, a CaptureMatcher must not
+	         be shared between threads
+
+*/
+
+class CaptureMatcher
+{
+public:
+	enum : size_t { NONE = SIZE_MAX };
+
+	enum Engine
+	{
+		ONE_PASS,
+		BACKTRACK,
+		PIKE_VM
+	};
+
+	CaptureMatcher(const char* pattern)
+		: onePass(pattern), backtracker(pattern), vm(pattern)
+	{
+	}
+
+	// number of groups, including group 0
+	size_t getGroupCount() const
+	{
+		return vm.getGroupCount();
+	}
+
+	// the engine a search of length bytes goes to
+	Engine engineFor(size_t length, bool fullMatch) const
+	{
+		if (fullMatch && onePass.isOnePass())
+		{
+			return ONE_PASS;
+		}
+		return length <= backtracker.getMaxLength() ? BACKTRACK : PIKE_VM;
+	}
+
+	// leftmost-first match in text[from, length), captures like PikeVM
+	bool find(const char* text, size_t length, std::vector<size_t>& captures, size_t from = 0)
+	{
+		if (from > length)
+		{
+			return false;
+		}
+		if (engineFor(length - from, false) == BACKTRACK)
+		{
+			return backtracker.find(text, length, captures, from);
+		}
+		return vm.find(text, length, captures, from);
+	}
+
+	// whether the whole text matches, with the captures of that match
+	bool match(const char* text, size_t length, std::vector<size_t>& captures)
+	{
+		switch (engineFor(length, true))
+		{
+		case ONE_PASS:
+			return onePass.match(text, length, captures);
+		case BACKTRACK:
+			return backtracker.match(text, length, captures);
+		default:
+			return vm.match(text, length, captures);
+		}
+	}
+
+private:
+	OnePassDFA onePass;
+	BoundedBacktracker backtracker;
+	PikeVM vm;
+};
+
+#endif
\ No newline at end of file
@@ -1,85 +1,139 @@
 #ifndef _HREG_CONTAINERS_
 #define _HREG_CONTAINERS_
 
+#include <cstdint>
+#include <iterator>
 #include "globals.h"
 
-// a copy-on-write set container
-// set of automata states are used and copied everywhere during regex compilation
+template <typename T>
+class SortedVectorSet;
+
+// hash of a set element (splitmix64's finalizer), a set hashes to the
+// sum of the hashes of its elements, which insert and remove update
+inline uint64_t HashElement(uint64_t e)
+{
+	e = (e ^ (e >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	e = (e ^ (e >> 27)) * 0x94d049bb133111ebULL;
+	return e ^ (e >> 31);
+}
+
+template <typename T>
+uint64_t HashElement(const SortedVectorSet<T>& e)
+{
+	return HashElement(e.getHash());
+}
+
+// a sorted set container
+// set of automata states are used and copied everywhere during regex
+// compilation, most of them hold a few states : up to INLINE_CAPACITY
+// elements are stored in the set itself (copying one allocates
+// nothing), larger sets move to a heap vector shared between copies
+// (copy-on-write)
 template <typename T>
 class SortedVectorSet
 {
 public:
+	enum : size_t { INLINE_CAPACITY = 8 };
+
+	typedef T value_type;
+	typedef const T* const_iterator;
+
 	SortedVectorSet()
+		: count(0), hash(0)
 	{
-		data = std::make_shared<std::vector<T>>();
 	}
-	SortedVectorSet(typename std::vector<T>::const_iterator b,
-					typename std::vector<T>::const_iterator e)
+	template <typename Iterator>
+	SortedVectorSet(Iterator b, Iterator e)
+		: count(0), hash(0)
 	{
-		data = std::make_shared<std::vector<T>>(b, e);
+		if (static_cast<size_t>(std::distance(b, e)) > INLINE_CAPACITY)
+		{
+			heap = std::make_shared<std::vector<T>>(b, e);
+		}
+		else
+		{
+			count = std::copy(b, e, local) - local;
+		}
+		for (auto i = begin(); i != end(); ++i)
+		{
+			hash += HashElement(*i);
+		}
 	}
 	bool insert(const T& e)
 	{
-		if (data.use_count() > 1)
+		auto iter = std::lower_bound(begin(), end(), e);
+		if (iter != end() && *iter == e)
 		{
-			// make a copy
-			data = std::make_shared<std::vector<T>>(data->begin(), data->end());
+			return false;
 		}
-		auto iter = std::lower_bound(data->begin(), data->end(), e);
-		if (iter == data->end() || *iter != e)
+		size_t position = iter - begin();
+		if (heap)
 		{
-			data->insert(iter, e);
-			return true;
+			unshare();
+			heap->insert(heap->begin() + position, e);
+		}
+		else if (count < INLINE_CAPACITY)
+		{
+			std::copy_backward(local + position, local + count, local + count + 1);
+			local[position] = e;
+			++count;
 		}
 		else
 		{
-			return false;
+			// move to the heap
+			heap = std::make_shared<std::vector<T>>();
+			heap->reserve(2 * INLINE_CAPACITY);
+			heap->insert(heap->end(), local, local + position);
+			heap->push_back(e);
+			heap->insert(heap->end(), local + position, local + count);
+			count = 0;
 		}
+		hash += HashElement(e);
+		return true;
 	}
 	bool remove(const T& e)
 	{
-		if (data.use_count() > 1)
+		auto iter = std::lower_bound(begin(), end(), e);
+		if (iter == end() || *iter != e)
 		{
-			// make a copy
-			data = std::make_shared<std::vector<T>>(data->begin(), data->end());
+			return false;
 		}
-		auto iter = std::lower_bound(data->begin(), data->end(), e);
-		if (iter == data->end() || *iter != e)
+		size_t position = iter - begin();
+		if (heap)
 		{
-			return false;
+			unshare();
+			heap->erase(heap->begin() + position);
 		}
 		else
 		{
-			data->erase(iter);
-			return true;
+			std::copy(local + position + 1, local + count, local + position);
+			--count;
 		}
+		hash -= HashElement(e);
+		return true;
 	}
 	void popBack()
 	{
-		if (data.use_count() > 1)
+		if (isEmpty())
 		{
-			// make a copy
-			data = std::make_shared<std::vector<T>>(data->begin(), data->end());
+			throw EmptyContainerError();
 		}
-		if (!data->empty())
+		hash -= HashElement(last());
+		if (heap)
 		{
-			data->pop_back();
+			unshare();
+			heap->pop_back();
 		}
 		else
 		{
-			throw EmptyContainerError();
+			--count;
 		}
 	}
 	void clear()
 	{
-		if (data.use_count() == 1)
-		{
-			data->clear();
-		}
-		else
-		{
-			data = std::make_shared<std::vector<T>>();
-		}
+		heap.reset();
+		count = 0;
+		hash = 0;
 	}
 	const T& last() const
 	{
@@ -95,7 +149,12 @@ public:
 	}
 	size_t size() const
 	{
-		return data->size();
+		return heap ? heap->size() : count;
+	}
+	// whether the elements are stored in the set itself
+	bool isInline() const
+	{
+		return !heap;
 	}
 	SortedVectorSet<T> operator||(const SortedVectorSet<T>& other) const
 	{
@@ -106,28 +165,28 @@ public:
 		{
 			if (*thisHead == *thatHead)
 			{
-				ret.data->push_back(*thisHead);
+				ret.append(*thisHead);
 				thisHead++;
 				thatHead++;
 			}
 			else if (*thisHead > *thatHead)
 			{
-				ret.data->push_back(*thatHead);
+				ret.append(*thatHead);
 				thatHead++;
 			}
 			else
 			{
-				ret.data->push_back(*thisHead);
+				ret.append(*thisHead);
 				thisHead++;
 			}
 		}
 		if (thisHead != end())
 		{
-			ret.data->insert(ret.data->end(), thisHead, end());
+			ret.append(thisHead, end());
 		}
 		else if (thatHead != other.end())
 		{
-			ret.data->insert(ret.data->end(), thatHead, other.end());
+			ret.append(thatHead, other.end());
 		}
 		return ret;
 	}
@@ -140,7 +199,7 @@ public:
 		{
 			if (*thisHead == *thatHead)
 			{
-				ret.data->push_back(*thisHead);
+				ret.append(*thisHead);
 				thisHead++;
 				thatHead++;
 			}
@@ -173,19 +232,23 @@ public:
 			}
 			else
 			{
-				ret.data->push_back(*thisHead);
+				ret.append(*thisHead);
 				thisHead++;
 			}
 		}
 		if (thisHead != end())
 		{
-			ret.data->insert(ret.data->end(), thisHead, end());
+			ret.append(thisHead, end());
 		}
 		return ret;
 	}
 	bool operator==(const SortedVectorSet& other) const
 	{
-		return (data == other.data || (*data) == (*other.data));
+		if (heap && heap == other.heap)
+		{
+			return true;
+		}
+		return hash == other.hash && size() == other.size() && std::equal(begin(), end(), other.begin());
 	}
 	bool operator!=(const SortedVectorSet& other) const
 	{
@@ -193,44 +256,954 @@ public:
 	}
 	bool operator<(const SortedVectorSet& other) const
 	{
-		if (data == other.data)
+		if (heap && heap == other.heap)
 		{
 			return false;
 		}
-		size_t s1 = size();
-		size_t s2 = other.size();
-		size_t smaller = s1 < s2 ? s1 : s2;
-		for (size_t i = 0; i < smaller; ++i)
+		return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
+	}
+	bool contains(const T& e) const
+	{
+		return std::binary_search(begin(), end(), e);
+	}
+	// whether the intersection is not empty, without building it
+	bool intersects(const SortedVectorSet<T>& other) const
+	{
+		auto thisHead = begin();
+		auto thatHead = other.begin();
+		while (thisHead != end() && thatHead != other.end())
 		{
-			if ((*data)[i] < (*other.data)[i])
+			if (*thisHead == *thatHead)
 			{
 				return true;
 			}
-			else if ((*other.data)[i] < (*data)[i])
+			else if (*thisHead > *thatHead)
+			{
+				thatHead++;
+			}
+			else
 			{
-				return false;
+				thisHead++;
 			}
 		}
-		if (s1 < s2)
+		return false;
+	}
+	const_iterator begin() const
+	{
+		return heap ? heap->data() : local;
+	}
+	const_iterator end() const
+	{
+		return heap ? heap->data() + heap->size() : local + count;
+	}
+	// equal sets have equal hashes
+	uint64_t getHash() const
+	{
+		return hash;
+	}
+private:
+	// copy the heap vector before writing to it, if it is shared
+	void unshare()
+	{
+		if (heap.use_count() > 1)
 		{
-			return true;
+			heap = std::make_shared<std::vector<T>>(*heap);
+		}
+	}
+	// only for a set being built, past its last element
+	void append(const T& e)
+	{
+		if (heap)
+		{
+			heap->push_back(e);
+		}
+		else if (count < INLINE_CAPACITY)
+		{
+			local[count++] = e;
+		}
+		else
+		{
+			heap = std::make_shared<std::vector<T>>(local, local + count);
+			heap->push_back(e);
+			count = 0;
+		}
+		hash += HashElement(e);
+	}
+	void append(const_iterator b, const_iterator e)
+	{
+		for (auto i = b; i != e; ++i)
+		{
+			append(*i);
+		}
+	}
+
+	// elements, when heap is null
+	T local[INLINE_CAPACITY];
+	size_t count;
+	std::shared_ptr<std::vector<T>> heap;
+	uint64_t hash;
+};
+
+// number of bits set in a word
+inline size_t PopCount(uint64_t w)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(w);
+#else
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return static_cast<size_t>((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// index of the lowest bit set, w must not be 0
+inline size_t LowestBit(uint64_t w)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(w);
+#else
+	return PopCount((w & (~w + 1)) - 1);
+#endif
+}
+
+// a set of integers in [0, capacity) as a row of bits, with the
+// interface of SortedVectorSet<size_t> : the two are interchangeable
+// state set policies (see Simplifier::NFAToDFA). Union, intersection,
+// difference and comparison are loops over contiguous words (which the
+// compiler vectorizes) whatever the number of elements, insertion is
+// constant time, the set grows to hold any element inserted. Up to
+// INLINE_WORDS words are stored in the set itself. The size and the
+// hash are counted again (one pass over the words) when asked for after
+// a change
+//
+// ! NOTE : every set takes capacity / 8 bytes, it suits a small
+//          universe (the states of a small NFA) holding large sets
+class DenseBitSet
+{
+public:
+	enum : size_t { INLINE_WORDS = 4 };
+
+	typedef size_t value_type;
+
+	// elements in ascending order
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef size_t value_type;
+		typedef ptrdiff_t difference_type;
+		typedef const size_t* pointer;
+		typedef size_t reference;
+
+		const_iterator()
+			: words(nullptr), length(0), index(0), bits(0)
+		{
+		}
+		const_iterator(const uint64_t* w, size_t n, size_t i)
+			: words(w), length(n), index(i), bits(i < n ? w[i] : 0)
+		{
+			skip();
+		}
+		size_t operator*() const
+		{
+			return index * 64 + LowestBit(bits);
+		}
+		const_iterator& operator++()
+		{
+			bits &= bits - 1;
+			skip();
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			const_iterator old = *this;
+			++*this;
+			return old;
+		}
+		bool operator==(const const_iterator& other) const
+		{
+			return index == other.index && bits == other.bits;
+		}
+		bool operator!=(const const_iterator& other) const
+		{
+			return !(operator==(other));
+		}
+	private:
+		// to the next word with a bit set, or to the end
+		void skip()
+		{
+			while (bits == 0 && index < length)
+			{
+				if (++index != length)
+				{
+					bits = words[index];
+				}
+			}
+		}
+		const uint64_t* words;
+		size_t length;
+		size_t index;
+		// bits of words[index] not visited yet
+		uint64_t bits;
+	};
+
+	DenseBitSet()
+		: length(0), count(0), hash(0), counted(true)
+	{
+	}
+	explicit DenseBitSet(size_t capacity)
+		: length(0), count(0), hash(0), counted(true)
+	{
+		resize((capacity + 63) / 64);
+	}
+	template <typename Iterator>
+	DenseBitSet(Iterator b, Iterator e)
+		: length(0), count(0), hash(0), counted(true)
+	{
+		for (; b != e; ++b)
+		{
+			insert(*b);
+		}
+	}
+	DenseBitSet(const DenseBitSet& other)
+		: length(0), count(other.count), hash(other.hash), counted(other.counted)
+	{
+		resize(other.length);
+		std::copy(other.data(), other.data() + length, data());
+	}
+	DenseBitSet(DenseBitSet&& other)
+		: heap(std::move(other.heap)), length(other.length),
+		  count(other.count), hash(other.hash), counted(other.counted)
+	{
+		std::copy(other.local, other.local + INLINE_WORDS, local);
+		other.length = 0;
+		other.count = 0;
+		other.hash = 0;
+		other.counted = true;
+	}
+	DenseBitSet& operator=(DenseBitSet other)
+	{
+		heap.swap(other.heap);
+		std::swap_ranges(local, local + INLINE_WORDS, other.local);
+		std::swap(length, other.length);
+		std::swap(count, other.count);
+		std::swap(hash, other.hash);
+		std::swap(counted, other.counted);
+		return *this;
+	}
+	bool insert(size_t e)
+	{
+		size_t w = e / 64;
+		if (w >= length)
+		{
+			resize(w + 1);
+		}
+		uint64_t bit = static_cast<uint64_t>(1) << (e % 64);
+		uint64_t& word = data()[w];
+		if (word & bit)
+		{
+			return false;
+		}
+		word |= bit;
+		counted = false;
+		return true;
+	}
+	bool remove(size_t e)
+	{
+		if (!contains(e))
+		{
+			return false;
+		}
+		data()[e / 64] &= ~(static_cast<uint64_t>(1) << (e % 64));
+		counted = false;
+		return true;
+	}
+	// keeps the capacity
+	void clear()
+	{
+		std::fill(data(), data() + length, 0);
+		count = 0;
+		hash = 0;
+		counted = true;
+	}
+	bool contains(size_t e) const
+	{
+		return e / 64 < length && ((data()[e / 64] >> (e % 64)) & 1) != 0;
+	}
+	bool isEmpty() const
+	{
+		if (counted)
+		{
+			return count == 0;
+		}
+		return std::find_if(data(), data() + length, [](uint64_t w)
+		{
+			return w != 0;
+		}) == data() + length;
+	}
+	size_t size() const
+	{
+		summarize();
+		return count;
+	}
+	bool intersects(const DenseBitSet& other) const
+	{
+		size_t common = std::min(length, other.length);
+		const uint64_t* a = data();
+		const uint64_t* b = other.data();
+		for (size_t i = 0; i != common; ++i)
+		{
+			if (a[i] & b[i])
+			{
+				return true;
+			}
 		}
 		return false;
 	}
-	bool contains(const T& e) const
+	DenseBitSet& operator|=(const DenseBitSet& other)
+	{
+		if (length < other.length)
+		{
+			resize(other.length);
+		}
+		uint64_t* a = data();
+		const uint64_t* b = other.data();
+		for (size_t i = 0; i != other.length; ++i)
+		{
+			a[i] |= b[i];
+		}
+		counted = false;
+		return *this;
+	}
+	DenseBitSet operator||(const DenseBitSet& other) const
+	{
+		DenseBitSet ret(*this);
+		ret |= other;
+		return ret;
+	}
+	DenseBitSet operator&&(const DenseBitSet& other) const
+	{
+		DenseBitSet ret;
+		ret.resize(std::min(length, other.length));
+		uint64_t* r = ret.data();
+		const uint64_t* a = data();
+		const uint64_t* b = other.data();
+		for (size_t i = 0; i != ret.length; ++i)
+		{
+			r[i] = a[i] & b[i];
+		}
+		ret.counted = false;
+		return ret;
+	}
+	DenseBitSet operator-(const DenseBitSet& other) const
+	{
+		DenseBitSet ret(*this);
+		size_t common = std::min(length, other.length);
+		uint64_t* r = ret.data();
+		const uint64_t* b = other.data();
+		for (size_t i = 0; i != common; ++i)
+		{
+			r[i] &= ~b[i];
+		}
+		ret.counted = false;
+		return ret;
+	}
+	// sets of different capacities are equal when they have the same
+	// elements : equal counts and equal common words leave no bit past
+	// the shorter row
+	bool operator==(const DenseBitSet& other) const
+	{
+		if (size() != other.size() || getHash() != other.getHash())
+		{
+			return false;
+		}
+		return std::equal(data(), data() + std::min(length, other.length), other.data());
+	}
+	bool operator!=(const DenseBitSet& other) const
+	{
+		return !(operator==(other));
+	}
+	// same order as SortedVectorSet
+	bool operator<(const DenseBitSet& other) const
+	{
+		return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
+	}
+	const_iterator begin() const
+	{
+		return const_iterator(data(), length, 0);
+	}
+	const_iterator end() const
+	{
+		return const_iterator(data(), length, length);
+	}
+	// equal sets have equal hashes
+	uint64_t getHash() const
+	{
+		summarize();
+		return hash;
+	}
+	// whether the words are stored in the set itself
+	bool isInline() const
+	{
+		return length <= INLINE_WORDS;
+	}
+private:
+	uint64_t* data()
+	{
+		return isInline() ? local : heap.data();
+	}
+	const uint64_t* data() const
+	{
+		return isInline() ? local : heap.data();
+	}
+	// to n words, the new ones cleared
+	void resize(size_t n)
+	{
+		if (n <= INLINE_WORDS)
+		{
+			std::fill(local + length, local + n, 0);
+		}
+		else
+		{
+			if (isInline())
+			{
+				heap.assign(local, local + length);
+			}
+			heap.resize(n, 0);
+		}
+		length = n;
+	}
+	// the hash is the sum over the words with a bit set
+	static uint64_t HashWord(size_t index, uint64_t word)
+	{
+		return word == 0 ? 0 : HashElement(word ^ HashElement(index));
+	}
+	void summarize() const
+	{
+		if (counted)
+		{
+			return;
+		}
+		count = 0;
+		hash = 0;
+		const uint64_t* words = data();
+		for (size_t i = 0; i != length; ++i)
+		{
+			count += PopCount(words[i]);
+			hash += HashWord(i, words[i]);
+		}
+		counted = true;
+	}
+
+	// words, when there are at most INLINE_WORDS of them
+	uint64_t local[INLINE_WORDS];
+	std::vector<uint64_t> heap;
+	size_t length;
+	// valid when counted, a change leaves them to summarize
+	mutable size_t count;
+	mutable uint64_t hash;
+	mutable bool counted;
+};
+
+// a fixed size array whose storage starts on a cache line boundary
+// only meant for plain old data (transition tables, bitmaps)
+template <typename T, size_t Alignment = 64>
+class AlignedArray
+{
+public:
+	AlignedArray()
+		: data(nullptr), count(0)
+	{
+	}
+	explicit AlignedArray(size_t n, const T& value = T())
+	{
+		allocate(n);
+		std::fill(data, data + count, value);
+	}
+	AlignedArray(const AlignedArray& other)
+	{
+		allocate(other.count);
+		std::copy(other.data, other.data + count, data);
+	}
+	AlignedArray(AlignedArray&& other)
+		: raw(std::move(other.raw)), data(other.data), count(other.count)
+	{
+		other.data = nullptr;
+		other.count = 0;
+	}
+	AlignedArray& operator=(AlignedArray other)
+	{
+		std::swap(raw, other.raw);
+		std::swap(data, other.data);
+		std::swap(count, other.count);
+		return *this;
+	}
+	T& operator[](size_t i)
+	{
+		return data[i];
+	}
+	const T& operator[](size_t i) const
+	{
+		return data[i];
+	}
+	size_t size() const
+	{
+		return count;
+	}
+	const T* begin() const
+	{
+		return data;
+	}
+	const T* end() const
+	{
+		return data + count;
+	}
+private:
+	void allocate(size_t n)
+	{
+		count = n;
+		raw.reset(new char[n * sizeof(T) + Alignment]);
+		auto address = reinterpret_cast<uintptr_t>(raw.get());
+		address = (address + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1);
+		data = reinterpret_cast<T*>(address);
+	}
+	std::unique_ptr<char[]> raw;
+	T* data;
+	size_t count;
+};
+
+// a set of integers in [0, capacity) (Briggs & Torczon) : insertion,
+// lookup and clear in constant time, iteration in insertion order, the
+// storage is allocated once
+class SparseSet
+{
+public:
+	SparseSet()
+		: count(0)
+	{
+	}
+	explicit SparseSet(size_t capacity)
+		: count(0)
+	{
+		allocate(capacity);
+	}
+	void allocate(size_t capacity)
+	{
+		sparse.resize(capacity);
+		dense.resize(capacity);
+		count = 0;
+	}
+	size_t capacity() const
+	{
+		return dense.size();
+	}
+	bool contains(size_t e) const
+	{
+		size_t i = sparse[e];
+		return i < count && dense[i] == e;
+	}
+	// index of e in insertion order, e must not be in the set
+	size_t insertNew(size_t e)
+	{
+		sparse[e] = count;
+		dense[count] = e;
+		return count++;
+	}
+	bool insert(size_t e)
+	{
+		if (contains(e))
+		{
+			return false;
+		}
+		insertNew(e);
+		return true;
+	}
+	void clear()
+	{
+		count = 0;
+	}
+	size_t size() const
+	{
+		return count;
+	}
+	bool isEmpty() const
+	{
+		return count == 0;
+	}
+	size_t operator[](size_t i) const
+	{
+		return dense[i];
+	}
+	std::vector<size_t>::const_iterator begin() const
+	{
+		return dense.begin();
+	}
+	std::vector<size_t>::const_iterator end() const
+	{
+		return dense.begin() + count;
+	}
+	void swap(SparseSet& other)
+	{
+		sparse.swap(other.sparse);
+		dense.swap(other.dense);
+		std::swap(count, other.count);
+	}
+private:
+	std::vector<size_t> sparse;
+	std::vector<size_t> dense;
+	size_t count;
+};
+
+// a partition of the integers in [0, n) refined by marking elements and
+// splitting the sets they are in (Valmari & Lehtinen) : every set is a
+// contiguous slice of one array, its marked elements first, so marking
+// is a swap and a split touches the smaller part only
+class RefinablePartition
+{
+public:
+	// element e starts in set keys[e], keys are in [0, setCount) and a
+	// set may start empty
+	RefinablePartition(const std::vector<size_t>& keys, size_t setCount)
+		: elements(keys.size()), location(keys.size()), setOf(keys.size()),
+		  lower(setCount + 1, 0)
+	{
+		for (auto k = keys.begin(); k != keys.end(); ++k)
+		{
+			++lower[*k + 1];
+		}
+		for (size_t i = 0; i != setCount; ++i)
+		{
+			lower[i + 1] += lower[i];
+		}
+		upper.assign(lower.begin() + 1, lower.end());
+		lower.pop_back();
+		std::vector<size_t> fill(lower);
+		for (size_t e = 0; e != keys.size(); ++e)
+		{
+			elements[fill[keys[e]]] = e;
+			location[e] = fill[keys[e]]++;
+			setOf[e] = keys[e];
+		}
+		middle = lower;
+	}
+	// number of sets
+	size_t size() const
+	{
+		return lower.size();
+	}
+	size_t setSize(size_t set) const
+	{
+		return upper[set] - lower[set];
+	}
+	size_t find(size_t e) const
+	{
+		return setOf[e];
+	}
+	std::vector<size_t>::const_iterator begin(size_t set) const
+	{
+		return elements.begin() + lower[set];
+	}
+	std::vector<size_t>::const_iterator end(size_t set) const
 	{
-		return std::binary_search(data->begin(), data->end(), e);
+		return elements.begin() + upper[set];
 	}
-	typename std::vector<T>::const_iterator begin() const
+	void mark(size_t e)
 	{
-		return data->begin();
+		size_t set = setOf[e];
+		size_t i = location[e];
+		size_t j = middle[set];
+		if (i < j)
+		{
+			return;
+		}
+		if (j == lower[set])
+		{
+			touched.push_back(set);
+		}
+		elements[i] = elements[j];
+		location[elements[i]] = i;
+		elements[j] = e;
+		location[e] = j;
+		++middle[set];
 	}
-	typename std::vector<T>::const_iterator end() const
+	// split the sets with marked elements, the smaller of the marked
+	// and the unmarked part becomes a new set (numbered from size()),
+	// every mark is cleared
+	void split()
 	{
-		return data->end();
+		for (auto t = touched.begin(); t != touched.end(); ++t)
+		{
+			size_t set = *t;
+			size_t marked = middle[set];
+			middle[set] = lower[set];
+			if (marked == upper[set])
+			{
+				continue;
+			}
+			size_t created = lower.size();
+			if (marked - lower[set] <= upper[set] - marked)
+			{
+				lower.push_back(lower[set]);
+				upper.push_back(marked);
+				lower[set] = marked;
+			}
+			else
+			{
+				lower.push_back(marked);
+				upper.push_back(upper[set]);
+				upper[set] = marked;
+			}
+			middle.push_back(lower[created]);
+			middle[set] = lower[set];
+			for (size_t i = lower[created]; i != upper[created]; ++i)
+			{
+				setOf[elements[i]] = created;
+			}
+		}
+		touched.clear();
 	}
 private:
-	std::shared_ptr<std::vector<T>> data;
+	std::vector<size_t> elements;
+	std::vector<size_t> location;
+	std::vector<size_t> setOf;
+	// set s is elements[lower[s], upper[s]), marked ones in [lower[s], middle[s])
+	std::vector<size_t> lower;
+	std::vector<size_t> upper;
+	std::vector<size_t> middle;
+	std::vector<size_t> touched;
+};
+
+// a hash-consing pool of sets, numbered in order of first insertion :
+// an open addressing table (linear probing) over the set hashes, every
+// distinct set is copied once into the pool's blocks. Equal sets get
+// the same id, so a set interned once is compared by id, and a lookup
+// is a hash probe and a comparison of contiguous elements. A set never
+// moves, its elements stay valid as long as the pool (the blocks do
+// not grow by copy, which would double the memory for a moment).
+// Nothing is freed set by set : clear() empties the pool keeping its
+// blocks for reuse, release() frees them, otherwise the blocks go with
+// the pool (a pool lives as long as one determinization or one cache,
+// see Simplifier::NFAToDFA and LazyDFA)
+// sets are SortedVectorSet<T> or DenseBitSet, one pool must be given
+// sets of one type (they hash differently). An iterator range hashes
+// like the SortedVectorSet of its elements and is compared in order, so
+// it may be a sequence (priority ordered threads for example)
+template <typename T>
+class SetInterner
+{
+public:
+	enum : size_t { NONE = SIZE_MAX, BLOCK_ELEMENTS = 4096, INITIAL_SLOTS = 16 };
+
+	// blocks hold blockElements elements
+	explicit SetInterner(size_t blockElements = BLOCK_ELEMENTS)
+		: slots(INITIAL_SLOTS, NONE), blockSize(std::max<size_t>(blockElements, 1)), block(0), used(0)
+	{
+	}
+	// number of sets
+	size_t size() const
+	{
+		return hashes.size();
+	}
+	// id of the set, NONE when absent
+	template <typename Set>
+	size_t find(const Set& set) const
+	{
+		return slots[probe(set.getHash(), set.begin(), set.end(), set.size())];
+	}
+	template <typename Iterator>
+	size_t find(Iterator b, Iterator e) const
+	{
+		return slots[probe(HashRange(b, e), b, e, std::distance(b, e))];
+	}
+	// id of the set, and whether it was just added (with the next id)
+	template <typename Set>
+	std::pair<size_t, bool> intern(const Set& set)
+	{
+		return insert(set.getHash(), set.begin(), set.end(), set.size());
+	}
+	template <typename Iterator>
+	std::pair<size_t, bool> intern(Iterator b, Iterator e)
+	{
+		return insert(HashRange(b, e), b, e, std::distance(b, e));
+	}
+	const T* begin(size_t id) const
+	{
+		return sets[id].first;
+	}
+	const T* end(size_t id) const
+	{
+		return sets[id].second;
+	}
+	// number of elements of a set
+	size_t size(size_t id) const
+	{
+		return sets[id].second - sets[id].first;
+	}
+	SortedVectorSet<T> get(size_t id) const
+	{
+		return SortedVectorSet<T>(begin(id), end(id));
+	}
+	void clear()
+	{
+		std::fill(slots.begin(), slots.end(), NONE);
+		hashes.clear();
+		sets.clear();
+		block = 0;
+		used = 0;
+	}
+	// clear and give the storage back
+	void release()
+	{
+		std::vector<size_t>(INITIAL_SLOTS, NONE).swap(slots);
+		std::vector<uint64_t>().swap(hashes);
+		std::vector<std::pair<const T*, const T*>>().swap(sets);
+		blocks.clear();
+		block = 0;
+		used = 0;
+	}
+	// bytes held : the blocks, the slot table and an entry per set
+	size_t getMemoryUsage() const
+	{
+		size_t bytes = slots.capacity() * sizeof(size_t) +
+			hashes.capacity() * sizeof(uint64_t) +
+			sets.capacity() * sizeof(std::pair<const T*, const T*>);
+		for (auto b = blocks.begin(); b != blocks.end(); ++b)
+		{
+			bytes += b->second * sizeof(T);
+		}
+		return bytes;
+	}
+	// bytes interning a new set of n elements adds at most : a block if
+	// the set fits in none left, the slot table if it doubles, the
+	// per-set entries if they grow
+	size_t getMemoryGrowth(size_t n) const
+	{
+		size_t bytes = 0;
+		if (n != 0 && !fits(n))
+		{
+			bytes += std::max(blockSize, n) * sizeof(T);
+		}
+		if ((hashes.size() + 1) * 2 > slots.size())
+		{
+			bytes += slots.size() * sizeof(size_t);
+		}
+		if (hashes.size() == hashes.capacity())
+		{
+			bytes += std::max<size_t>(hashes.capacity(), 1) * sizeof(uint64_t);
+		}
+		if (sets.size() == sets.capacity())
+		{
+			bytes += std::max<size_t>(sets.capacity(), 1) * sizeof(std::pair<const T*, const T*>);
+		}
+		return bytes;
+	}
+private:
+	template <typename Iterator>
+	static uint64_t HashRange(Iterator b, Iterator e)
+	{
+		uint64_t hash = 0;
+		for (; b != e; ++b)
+		{
+			hash += HashElement(*b);
+		}
+		return hash;
+	}
+	template <typename Iterator>
+	std::pair<size_t, bool> insert(uint64_t hash, Iterator b, Iterator e, size_t n)
+	{
+		size_t slot = probe(hash, b, e, n);
+		if (slots[slot] != NONE)
+		{
+			return std::make_pair(slots[slot], false);
+		}
+		size_t id = hashes.size();
+		slots[slot] = id;
+		hashes.push_back(hash);
+		T* first = allocate(n);
+		sets.push_back(std::make_pair(first, std::copy(b, e, first)));
+		// at most half full
+		if (hashes.size() * 2 > slots.size())
+		{
+			grow();
+		}
+		return std::make_pair(id, true);
+	}
+	// whether n elements fit in the current block or a later one
+	bool fits(size_t n) const
+	{
+		for (size_t b = block; b < blocks.size(); ++b)
+		{
+			if (blocks[b].second - (b == block ? used : 0) >= n)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	// room for n elements, in the current block or the next one large
+	// enough (a set larger than a block gets a block of its own)
+	T* allocate(size_t n)
+	{
+		if (n == 0)
+		{
+			return nullptr;
+		}
+		while (block != blocks.size() && blocks[block].second - used < n)
+		{
+			++block;
+			used = 0;
+		}
+		if (block == blocks.size())
+		{
+			size_t capacity = std::max(blockSize, n);
+			blocks.push_back(std::make_pair(std::unique_ptr<T[]>(new T[capacity]), capacity));
+		}
+		T* result = blocks[block].first.get() + used;
+		used += n;
+		return result;
+	}
+	// the slot holding the set of n elements [b, e), or the empty slot
+	// it would go in
+	template <typename Iterator>
+	size_t probe(uint64_t hash, Iterator b, Iterator e, size_t n) const
+	{
+		size_t mask = slots.size() - 1;
+		for (size_t slot = static_cast<size_t>(hash) & mask; ; slot = (slot + 1) & mask)
+		{
+			size_t id = slots[slot];
+			if (id == NONE || (hashes[id] == hash && size(id) == n && std::equal(b, e, begin(id))))
+			{
+				return slot;
+			}
+		}
+	}
+	void grow()
+	{
+		slots.assign(slots.size() * 2, NONE);
+		size_t mask = slots.size() - 1;
+		for (size_t id = 0; id != hashes.size(); ++id)
+		{
+			size_t slot = static_cast<size_t>(hashes[id]) & mask;
+			while (slots[slot] != NONE)
+			{
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = id;
+		}
+	}
+
+	// ids, a power of two of them
+	std::vector<size_t> slots;
+	std::vector<uint64_t> hashes;
+	// elements of every set, [first, second)
+	std::vector<std::pair<const T*, const T*>> sets;
+	// storage and capacity, sets are allocated in blocks[block] past
+	// the first used elements
+	std::vector<std::pair<std::unique_ptr<T[]>, size_t>> blocks;
+	size_t blockSize;
+	size_t block;
+	size_t used;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+#ifndef _HREG_DENSEDFA_
+#define _HREG_DENSEDFA_
+
+#include "automata.h"
+#include "alphabet.h"
+
+/*
+
+	Table driven DFA
+
+	Compiled once from the output of Simplifier::NFAToDFA / MinimizeDFA,
+	then used read-only. Input characters are first mapped to a symbol
+	class (see alphabet.h), the transition table is indexed by
+	(state, class), and the match loop neither allocates nor touches the
+	original Automata.
+
+	Rows are stored premultiplied by the class count, so the next state
+	is a single load : table[current + class]. Row 0 is the dead state.
+
+	! NOTE : premultiplied ids are 32 bits, a DFA whose states * classes
+	do not fit throws TooManyStatesError.
+
+*/
+
+class DenseDFA
+{
+public:
+	typedef uint32_t DenseState;
+
+	enum { DEAD = 0 };
+
+	// throw TooManyStatesError when states * classes exceeds UINT32_MAX
+	DenseDFA(const Automata& dfa)
+		: classes(dfa), classCount(classes.size())
+	{
+		size_t stateCount = dfa.size() + 1;
+		if (classCount != 0 && stateCount > UINT32_MAX / classCount)
+		{
+			throw TooManyStatesError();
+		}
+		table = AlignedArray<DenseState>(stateCount * classCount, DEAD);
+		accept = AlignedArray<uint64_t>((stateCount + 63) / 64, 0);
+		labels.resize(stateCount);
+		start = DEAD;
+		if (dfa.size() == 0)
+		{
+			return;
+		}
+		auto starts = dfa.getStart();
+		if (starts.size() != 1)
+		{
+			throw IllegalStateError();
+		}
+		start = toDense(starts.last());
+		for (State s = 0; s != dfa.size(); ++s)
+		{
+			if (dfa.isTerminate(s))
+			{
+				size_t row = s + 1;
+				accept[row / 64] |= (static_cast<uint64_t>(1) << (row % 64));
+				labels[row] = dfa.getLabels(s);
+			}
+			auto& edges = dfa.getNeighbours(s);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				fillRow(toDense(s), toDense(e->getTo()), e->getTransition());
+			}
+		}
+	}
+
+	template <EncodeType E>
+	bool match(typename Encode<E>::PointerType str, size_t length) const
+	{
+		StreamReader<E> reader(str);
+		DenseState current = start;
+		for (size_t i = 0; i < length; ++i)
+		{
+			current = table[current + classOf(reader.next())];
+			if (current == DEAD)
+			{
+				return false;
+			}
+		}
+		return isAccepting(current);
+	}
+
+	// number of states, including the dead state
+	size_t size() const
+	{
+		return table.size() / classCount;
+	}
+
+	size_t getClassCount() const
+	{
+		return classCount;
+	}
+
+	DenseState getStart() const
+	{
+		return start;
+	}
+
+	DenseState next(DenseState current, UnicodeChar ch) const
+	{
+		return table[current + classOf(ch)];
+	}
+
+	bool isAccepting(DenseState s) const
+	{
+		size_t row = s / classCount;
+		return (accept[row / 64] >> (row % 64)) & 1;
+	}
+
+	// labels of an accepting state (see Automata::setTerminate)
+	const SortedVectorSet<size_t>& getLabels(DenseState s) const
+	{
+		return labels[s / classCount];
+	}
+
+	size_t classOf(UnicodeChar ch) const
+	{
+		return classes.classOf(ch);
+	}
+
+	const SymbolClasses& getClasses() const
+	{
+		return classes;
+	}
+
+private:
+	DenseState toDense(State s) const
+	{
+		return static_cast<DenseState>((s + 1) * classCount);
+	}
+
+	void setEntry(DenseState from, size_t cls, DenseState to)
+	{
+		DenseState& entry = table[from + cls];
+		if (entry != DEAD && entry != to)
+		{
+			// two edges leave the same state on the same character
+			throw IllegalStateError();
+		}
+		entry = to;
+	}
+
+	void fillRow(DenseState from, DenseState to, const Transition& t)
+	{
+		if (t.getType() == Transition::EPSILON)
+		{
+			throw IllegalStateError();
+		}
+		auto covered = classes.classesOf(t);
+		for (auto c = covered.begin(); c != covered.end(); ++c)
+		{
+			setEntry(from, *c, to);
+		}
+	}
+
+	SymbolClasses classes;
+	size_t classCount;
+	AlignedArray<DenseState> table;
+	AlignedArray<uint64_t> accept;
+	std::vector<SortedVectorSet<size_t>> labels;
+	DenseState start;
+};
+
+#endif
\ No newline at end of file
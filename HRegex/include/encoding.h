@@ -21,7 +21,8 @@ enum EncodeType
 {
 	ASCII,
 	UTF8,
-	UTF16
+	UTF16,
+	RAW
 };
 
 template <EncodeType E>
@@ -52,6 +53,12 @@ struct Encode<UTF16>
 #endif
 };
 
+template <>
+struct Encode<RAW>
+{
+	typedef const char *PointerType;
+};
+
 template <>
 class StreamReader<ASCII>
 {
@@ -202,4 +209,31 @@ private:
 	UnicodeChar nextChar;
 };
 
+// every byte is a symbol, used by automata compiled to byte level
+// (see utf8ranges.h). NUL is an ordinary byte and nothing is read ahead,
+// so the caller's length is the only bound.
+template <>
+class StreamReader<RAW>
+{
+	typedef Encode<RAW>::PointerType PointerType;
+public:
+	StreamReader(PointerType input) : data(input)
+	{
+		if (data == nullptr)
+		{
+			throw NullPointerError();
+		}
+	}
+	UnicodeChar next()
+	{
+		return static_cast<unsigned char>(*data++);
+	}
+	UnicodeChar peek() const
+	{
+		return static_cast<unsigned char>(*data);
+	}
+private:
+	PointerType data;
+};
+
 #endif
\ No newline at end of file
@@ -12,6 +12,8 @@ class IllegalStateError {};
 class ParseError {};
 class NullPointerError {};
 class EmptyContainerError {};
+class TooManyStatesError {};
+class LexError {};
 
 typedef unsigned char HRegexByte;
 
@@ -0,0 +1,301 @@
+#ifndef _HREG_LAZYDFA_
+#define _HREG_LAZYDFA_
+
+#include "automata.h"
+#include "alphabet.h"
+
+/*
+
+	Lazy (on-the-fly) DFA
+
+	Instead of determinizing every reachable subset up front like
+	Simplifier::NFAToDFA, a DFA state is built only when the input
+	actually reaches it, then cached together with a row of
+	(symbol class -> next state) entries that are filled on demand.
+
+	The cache is bounded : when the memory held by the cache (the set
+	pool's blocks and slot table, the rows) would exceed the budget, the
+	whole cache is flushed, its storage freed, and rebuilt from the state
+	the match is currently in. Matching stays correct whatever the
+	budget is, a budget too small only costs determinization time (a
+	single state larger than the budget is still cached).
+
+	With LEFTMOST_FIRST, a DFA state is the list of NFA threads in
+	priority order (the order edges were added in, as in a backtracking
+	matcher) instead of a sorted set. Once a thread reaches a terminate
+	state every lower priority thread is dropped, so a scan that keeps
+	going until the dead state ends exactly where the leftmost-first
+	match ends.
+
+	! NOTE : matching mutates the cache, a LazyDFA must not be shared
+	         between threads
+
+*/
+
+enum MatchKind
+{
+	// plain subset construction, accept when any thread accepts
+	ALL_MATCHES,
+	// priority ordered threads, cut off after the first accepting one
+	LEFTMOST_FIRST
+};
+
+class LazyDFA
+{
+public:
+	typedef uint32_t CachedState;
+
+	enum
+	{
+		DEAD = 0,
+		UNKNOWN = UINT32_MAX
+	};
+
+	static const size_t DEFAULT_BUDGET = 1 << 20;
+
+	LazyDFA(const Automata& automata, MatchKind matchKind = ALL_MATCHES,
+		size_t cacheBudget = DEFAULT_BUDGET)
+		: nfa(automata), closures(automata), classes(automata), kind(matchKind),
+		  budget(cacheBudget), flushes(0),
+		  cache(std::min<size_t>(SetInterner<State>::BLOCK_ELEMENTS, cacheBudget / 8 / sizeof(State))),
+		  marked(automata.size())
+	{
+		flush();
+	}
+
+	template <EncodeType E>
+	bool match(typename Encode<E>::PointerType str, size_t length)
+	{
+		StreamReader<E> reader(str);
+		CachedState current = getStart();
+		for (size_t i = 0; i < length; ++i)
+		{
+			current = next(current, reader.next());
+			if (current == DEAD)
+			{
+				return false;
+			}
+		}
+		return isAccepting(current);
+	}
+
+	CachedState getStart()
+	{
+		if (start == UNKNOWN)
+		{
+			seeds.assign(nfa.getStart().begin(), nfa.getStart().end());
+			start = intern(closure());
+		}
+		return start;
+	}
+
+	// ! NOTE : any state handle obtained earlier is invalidated when the
+	//          cache is flushed, only the returned one stays valid
+	CachedState next(CachedState current, UnicodeChar ch)
+	{
+		size_t cls = classes.classOf(ch);
+		CachedState result = transitions[current * classes.size() + cls];
+		if (result != UNKNOWN)
+		{
+			return result;
+		}
+		return computeNext(current, cls);
+	}
+
+	bool isAccepting(CachedState s) const
+	{
+		return accepting[s];
+	}
+
+	// false as well while the start state is not (re)built
+	bool isStart(CachedState s) const
+	{
+		return s == start;
+	}
+
+	// number of cached states, including the dead state
+	size_t size() const
+	{
+		return cache.size();
+	}
+
+	// bytes held by the cache
+	size_t getMemoryUsage() const
+	{
+		return cache.getMemoryUsage() +
+			transitions.capacity() * sizeof(CachedState) +
+			accepting.capacity() / 8;
+	}
+
+	size_t getFlushCount() const
+	{
+		return flushes;
+	}
+
+private:
+	CachedState computeNext(CachedState current, size_t cls)
+	{
+		UnicodeChar ch = classes.representative(cls);
+		seeds.clear();
+		for (auto i = cache.begin(current); i != cache.end(current); ++i)
+		{
+			auto& edges = nfa.getNeighbours(*i);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				Transition t = e->getTransition();
+				if (t.getType() != Transition::EPSILON && t.check(ch))
+				{
+					seeds.push_back(e->getTo());
+				}
+			}
+		}
+		size_t flushesBefore = flushes;
+		CachedState result = intern(closure());
+		if (flushes == flushesBefore)
+		{
+			transitions[current * classes.size() + cls] = result;
+		}
+		return result;
+	}
+
+	// the threads reached from seeds, the scratch members are cleared
+	// and reused so that no closure allocates once they have grown
+	const std::vector<State>& closure()
+	{
+		threads.clear();
+		marked.clear();
+		if (kind == ALL_MATCHES)
+		{
+			// merge of the precomputed closures
+			for (auto seed = seeds.begin(); seed != seeds.end(); ++seed)
+			{
+				for (auto s = closures.begin(*seed); s != closures.end(*seed); ++s)
+				{
+					if (marked.insert(*s))
+					{
+						threads.push_back(*s);
+					}
+				}
+			}
+			std::sort(threads.begin(), threads.end());
+			return threads;
+		}
+		// depth first, in edge order, keeping only the states that
+		// consume input or accept
+		for (auto seed = seeds.begin(); seed != seeds.end(); ++seed)
+		{
+			stk.push_back(*seed);
+			while (!stk.empty())
+			{
+				State s = stk.back();
+				stk.pop_back();
+				if (!marked.insert(s))
+				{
+					continue;
+				}
+				auto& edges = nfa.getNeighbours(s);
+				bool consumes = false;
+				for (auto e = edges.rbegin(); e != edges.rend(); ++e)
+				{
+					if (e->getTransition().getType() == Transition::EPSILON)
+					{
+						stk.push_back(e->getTo());
+					}
+					else
+					{
+						consumes = true;
+					}
+				}
+				if (nfa.isTerminate(s))
+				{
+					// lower priority threads can only match later
+					threads.push_back(s);
+					stk.clear();
+					return threads;
+				}
+				if (consumes)
+				{
+					threads.push_back(s);
+				}
+			}
+		}
+		return threads;
+	}
+
+	// capacity of a table of the cache growing to need entries : it
+	// doubles, so caching a state costs amortized constant time
+	static size_t Grown(size_t capacity, size_t need)
+	{
+		return need > capacity ? std::max(2 * capacity, need) : capacity;
+	}
+
+	// bytes caching a state of these threads would add
+	size_t stateCost(const std::vector<State>& s) const
+	{
+		return cache.getMemoryGrowth(s.size()) +
+			(Grown(transitions.capacity(), transitions.size() + classes.size()) - transitions.capacity()) *
+				sizeof(CachedState) +
+			(Grown(accepting.capacity(), accepting.size() + 1) - accepting.capacity()) / 8;
+	}
+
+	CachedState intern(const std::vector<State>& s)
+	{
+		if (s.empty())
+		{
+			return DEAD;
+		}
+		size_t found = cache.find(s.begin(), s.end());
+		if (found != SetInterner<State>::NONE)
+		{
+			return static_cast<CachedState>(found);
+		}
+		if (getMemoryUsage() + stateCost(s) > budget && cache.size() > 1)
+		{
+			flush();
+			++flushes;
+		}
+		CachedState id = static_cast<CachedState>(cache.intern(s.begin(), s.end()).first);
+		accepting.reserve(Grown(accepting.capacity(), accepting.size() + 1));
+		accepting.push_back(std::find_if(s.begin(), s.end(), [&](State st)
+		{
+			return nfa.isTerminate(st);
+		}) != s.end());
+		transitions.reserve(Grown(transitions.capacity(), transitions.size() + classes.size()));
+		transitions.resize(transitions.size() + classes.size(), UNKNOWN);
+		return id;
+	}
+
+	// the storage is freed, a flushed cache holds what it is refilled
+	// with only
+	void flush()
+	{
+		cache.release();
+		std::vector<bool>().swap(accepting);
+		std::vector<CachedState>().swap(transitions);
+		start = UNKNOWN;
+		// the dead state is never flushed, all its entries lead to itself
+		std::vector<State> dead;
+		cache.intern(dead.begin(), dead.end());
+		accepting.push_back(false);
+		transitions.resize(classes.size(), DEAD);
+	}
+
+	Automata nfa;
+	EpsilonClosures closures;
+	SymbolClasses classes;
+	MatchKind kind;
+	size_t budget;
+	size_t flushes;
+	CachedState start;
+	// threads of cached state i are set i
+	SetInterner<State> cache;
+	std::vector<bool> accepting;
+	std::vector<CachedState> transitions;
+	// scratch of computeNext and closure
+	std::vector<State> seeds;
+	std::vector<State> threads;
+	std::vector<State> stk;
+	SparseSet marked;
+};
+
+#endif
\ No newline at end of file
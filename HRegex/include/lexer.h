@@ -0,0 +1,157 @@
+#ifndef _HREG_LEXER_
+#define _HREG_LEXER_
+
+#include "regexset.h"
+#include <unordered_set>
+
+/*
+
+	Tokenizer generated from a list of rules
+
+	The rules are joined into one anchored byte DFA (see
+	RegexSet::Union), the accepting states labelled with the rules they
+	accept. At each offset the DFA runs as far as it can, the last
+	accepting position gives the token (maximal munch) and the smallest
+	label gives its rule, so an earlier rule wins over a later one
+	matching the same text ("if" before [a-z]+).
+
+	Tokens are never empty : a rule matching the empty string only
+	counts when it consumes at least one byte. Offsets and lengths are in
+	bytes of the UTF-8 input.
+
+	! NOTE : running past the token is what makes maximal munch costly,
+	with { "a*b", "a" } every "a" of a long run of them scans to the end
+	of the run. tokenize() remembers the (offset, state) pairs a scan
+	passed after its last accepting position : no accepting position lies
+	beyond them, so a later scan reaching one stops there. Each pair is
+	remembered once, which keeps tokenize() linear in the input (Reps,
+	"Maximal-munch tokenization in linear time"). A loop over nextToken()
+	has no such memory and is quadratic in the worst case.
+
+*/
+
+struct Token
+{
+	size_t id;
+	size_t offset;
+	size_t length;
+};
+
+class Lexer
+{
+public:
+	Lexer(const std::vector<std::string>& rules)
+		: count(rules.size()), dfa(Compile(rules))
+	{
+	}
+
+	// number of rules
+	size_t size() const
+	{
+		return count;
+	}
+
+	// the longest token at offset, false at the end of the input
+	// throw LexError if no rule matches there
+	bool nextToken(const char* text, size_t length, size_t offset, Token& token) const
+	{
+		return scan(text, length, offset, token, nullptr);
+	}
+
+	// split the whole input into tokens
+	// throw LexError if some part matches no rule
+	std::vector<Token> tokenize(const char* text, size_t length) const
+	{
+		std::vector<Token> tokens;
+		Token token;
+		size_t offset = 0;
+		Visited dead(0, VisitHash(dfa));
+		while (scan(text, length, offset, token, &dead))
+		{
+			tokens.push_back(token);
+			offset += token.length;
+		}
+		return tokens;
+	}
+
+private:
+	typedef std::pair<size_t, DenseDFA::DenseState> Visit;
+
+	// the index of the pair in an (offset, row) table : states are
+	// premultiplied by the class count, their row is a dense number
+	struct VisitHash
+	{
+		VisitHash(const DenseDFA& dfa)
+			: stateCount(dfa.size()), classCount(dfa.getClassCount())
+		{
+		}
+
+		size_t operator()(const Visit& v) const
+		{
+			return std::hash<size_t>()(v.first * stateCount + v.second / classCount);
+		}
+
+		size_t stateCount;
+		size_t classCount;
+	};
+
+	typedef std::unordered_set<Visit, VisitHash> Visited;
+
+	// nextToken, stopping at and adding to the dead pairs when given
+	bool scan(const char* text, size_t length, size_t offset, Token& token, Visited* dead) const
+	{
+		if (offset >= length)
+		{
+			return false;
+		}
+		DenseDFA::DenseState current = dfa.getStart();
+		size_t end = offset;
+		// pairs passed after the last accepting position
+		std::vector<Visit> trail;
+		for (size_t i = offset; i < length; ++i)
+		{
+			if (dead != nullptr && i > end)
+			{
+				Visit visit(i, current);
+				if (!dead->empty() && dead->count(visit) != 0)
+				{
+					break;
+				}
+				trail.push_back(visit);
+			}
+			current = dfa.next(current, static_cast<HRegexByte>(text[i]));
+			if (current == DenseDFA::DEAD)
+			{
+				break;
+			}
+			if (dfa.isAccepting(current))
+			{
+				end = i + 1;
+				token.id = *dfa.getLabels(current).begin();
+				trail.clear();
+			}
+		}
+		if (end == offset)
+		{
+			throw LexError();
+		}
+		if (dead != nullptr)
+		{
+			dead->insert(trail.begin(), trail.end());
+		}
+		token.offset = offset;
+		token.length = end - offset;
+		return true;
+	}
+
+	static Automata Compile(const std::vector<std::string>& rules)
+	{
+		Automata all = RegexSet::Union(rules);
+		return Simplifier::Minimize(Simplifier::NFAToDFA(all, SymbolClasses(all)));
+	}
+
+	size_t count;
+	DenseDFA dfa;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef _HREG_NFASIM_
+#define _HREG_NFASIM_
+
+#include "automata.h"
+
+/*
+
+	Thompson NFA simulator
+
+	Matches with an NFA directly, for patterns whose DFA cannot be
+	built. Compared to Automata::simulate, everything that does not
+	depend on the text is done once :
+
+	- the epsilon closure of every state is computed up front and kept
+	  as a list of the states in it that consume input or accept (see
+	  EpsilonClosures::IMPORTANT_STATES),
+	- the two state sets are sparse sets (see SparseSet) allocated with
+	  the simulator.
+
+	A step walks the transitions of the current states and inserts the
+	precomputed closure of every target, without allocating.
+
+	The closure lists take O(n^2) memory in the worst case, but only the
+	important states are kept, which is far below that for Thompson
+	automata.
+
+	! NOTE : the state sets are reused by every run, an NFASimulator must
+	         not be shared between threads
+
+*/
+
+class NFASimulator
+{
+public:
+	NFASimulator(const Automata& automata)
+		: nfa(automata), accepting(automata.size(), false),
+		  closures(automata, EpsilonClosures::IMPORTANT_STATES),
+		  current(automata.size()), next(automata.size())
+	{
+		for (State s = 0; s != nfa.size(); ++s)
+		{
+			accepting[s] = nfa.isTerminate(s);
+		}
+	}
+
+	// whether the whole text matches
+	template <EncodeType E>
+	bool simulate(typename Encode<E>::PointerType str, size_t length)
+	{
+		StreamReader<E> reader(str);
+		current.clear();
+		auto starts = nfa.getStart();
+		for (auto i = starts.begin(); i != starts.end(); ++i)
+		{
+			addClosure(current, *i);
+		}
+		for (size_t i = 0; i < length && !current.isEmpty(); ++i)
+		{
+			UnicodeChar ch = reader.next();
+			next.clear();
+			for (auto s = current.begin(); s != current.end(); ++s)
+			{
+				auto& edges = nfa.getNeighbours(*s);
+				for (auto e = edges.begin(); e != edges.end(); ++e)
+				{
+					const Transition& t = e->getTransition();
+					if (t.getType() != Transition::EPSILON && t.check(ch))
+					{
+						addClosure(next, e->getTo());
+					}
+				}
+			}
+			current.swap(next);
+		}
+		return std::find_if(current.begin(), current.end(), [&](size_t s)
+		{
+			return accepting[s];
+		}) != current.end();
+	}
+
+	// number of states kept in the closure lists
+	size_t getClosureSize() const
+	{
+		return closures.getClosureSize();
+	}
+
+private:
+	void addClosure(SparseSet& states, State s)
+	{
+		for (auto t = closures.begin(s); t != closures.end(s); ++t)
+		{
+			states.insert(*t);
+		}
+	}
+
+	Automata nfa;
+	std::vector<bool> accepting;
+	EpsilonClosures closures;
+	SparseSet current;
+	SparseSet next;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,264 @@
+#ifndef _HREG_ONEPASS_
+#define _HREG_ONEPASS_
+
+#include "parser.h"
+#include "utf8ranges.h"
+#include "alphabet.h"
+
+/*
+
+	One-pass DFA
+
+	A pattern is one-pass when, matched from the start of the input, at
+	most one NFA thread can consume each byte : (\d+)-(\d+) is, (a|ab)c
+	and (a*)(a*) are not. Then a DFA state needs no more than a single NFA
+	state (the one the last byte led to), and the capture slots written
+	on the epsilon path to the next consuming state can be stored on the
+	DFA transition itself, as a bit mask of slots to set to the current
+	offset. Matching is one table lookup per byte, with captures.
+
+	The analysis is done while building the table : following the
+	epsilon closure of every reachable state, the pattern is rejected as
+	soon as two paths consume the same byte class (or reach the terminate
+	state) with different targets or different slot updates.
+
+	Only full matches are supported (the whole input must match), with
+	at most 31 capture groups.
+
+*/
+
+class OnePassDFA
+{
+public:
+	enum : size_t { NONE = SIZE_MAX };
+
+	OnePassDFA(const char* pattern)
+		: onePass(true)
+	{
+		Automata codepoints;
+		Parser<UTF8> parser(pattern, codepoints);
+		nfa = UTF8Ranges::CompileToBytes(codepoints);
+		classes = SymbolClasses(nfa);
+		slotCount = 2 * (parser.getCaptureCount() + 1);
+		if (slotCount > 64)
+		{
+			onePass = false;
+			return;
+		}
+		build();
+	}
+
+	// false if the pattern needs more than one thread somewhere
+	bool isOnePass() const
+	{
+		return onePass;
+	}
+
+	// number of groups, including group 0
+	size_t getGroupCount() const
+	{
+		return slotCount / 2;
+	}
+
+	// number of DFA states, including the dead state
+	size_t size() const
+	{
+		return onePass ? rowState.size() : 0;
+	}
+
+	// whether the whole text matches, captures like PikeVM::match
+	// (unspecified when false is returned)
+	// throw IllegalStateError if the pattern is not one-pass
+	bool match(const char* text, size_t length, std::vector<size_t>& captures) const
+	{
+		if (!onePass)
+		{
+			throw IllegalStateError();
+		}
+		captures.assign(slotCount, NONE);
+		if (rowState.size() == 1)
+		{
+			// the empty pattern
+			return false;
+		}
+		const HRegexByte* str = reinterpret_cast<const HRegexByte*>(text);
+		size_t current = START;
+		for (size_t i = 0; i < length; ++i)
+		{
+			const Entry& e = table[current * classes.size() + classes.classOf(str[i])];
+			if (e.next == DEAD)
+			{
+				return false;
+			}
+			apply(e.slots, i, captures);
+			current = e.next;
+		}
+		if (!accepting[current])
+		{
+			return false;
+		}
+		apply(matchSlots[current], length, captures);
+		captures[0] = 0;
+		captures[1] = length;
+		return true;
+	}
+
+private:
+	enum { DEAD = 0, START = 1 };
+
+	struct Entry
+	{
+		uint32_t next;
+		uint64_t slots;
+	};
+
+	static void apply(uint64_t slots, size_t position, std::vector<size_t>& captures)
+	{
+		for (size_t i = 0; slots != 0; ++i, slots >>= 1)
+		{
+			if (slots & 1)
+			{
+				captures[i] = position;
+			}
+		}
+	}
+
+	void build()
+	{
+		// row 0 is the dead state
+		rowState.push_back(0);
+		accepting.push_back(false);
+		matchSlots.push_back(0);
+		table.resize(classes.size(), Entry{ DEAD, 0 });
+		if (nfa.size() == 0)
+		{
+			return;
+		}
+		std::map<State, uint32_t> stateToRow;
+		std::stack<uint32_t> work;
+		auto addRow = [&](State s) -> uint32_t
+		{
+			auto found = stateToRow.find(s);
+			if (found != stateToRow.end())
+			{
+				return found->second;
+			}
+			uint32_t row = static_cast<uint32_t>(rowState.size());
+			stateToRow[s] = row;
+			rowState.push_back(s);
+			accepting.push_back(false);
+			matchSlots.push_back(0);
+			table.resize(table.size() + classes.size(), Entry{ DEAD, 0 });
+			work.push(row);
+			return row;
+		};
+		addRow(nfa.getStart().last());
+		std::vector<std::pair<State, uint64_t>> reached;
+		while (!work.empty() && onePass)
+		{
+			uint32_t row = work.top();
+			work.pop();
+			if (!closure(rowState[row], reached))
+			{
+				onePass = false;
+				break;
+			}
+			for (auto r = reached.begin(); r != reached.end() && onePass; ++r)
+			{
+				if (nfa.isTerminate(r->first))
+				{
+					if (accepting[row] && matchSlots[row] != r->second)
+					{
+						onePass = false;
+					}
+					accepting[row] = true;
+					matchSlots[row] = r->second;
+				}
+				auto& edges = nfa.getNeighbours(r->first);
+				for (auto e = edges.begin(); e != edges.end() && onePass; ++e)
+				{
+					const Transition& t = e->getTransition();
+					if (t.getType() == Transition::EPSILON)
+					{
+						continue;
+					}
+					uint32_t next = addRow(e->getTo());
+					auto covered = classes.classesOf(t);
+					for (auto c = covered.begin(); c != covered.end(); ++c)
+					{
+						Entry& entry = table[row * classes.size() + *c];
+						if (entry.next != DEAD && (entry.next != next || entry.slots != r->second))
+						{
+							// two threads would consume the same byte
+							onePass = false;
+							break;
+						}
+						entry.next = next;
+						entry.slots = r->second;
+					}
+				}
+			}
+		}
+		if (!onePass)
+		{
+			table.clear();
+			rowState.clear();
+			accepting.clear();
+			matchSlots.clear();
+		}
+	}
+
+	// states reachable from s by epsilon transitions, with the slots
+	// written on the way, false if one is reached with two different
+	// slot updates
+	bool closure(State s, std::vector<std::pair<State, uint64_t>>& reached) const
+	{
+		reached.clear();
+		std::map<State, uint64_t> seen;
+		std::stack<std::pair<State, uint64_t>> stk;
+		stk.push(std::make_pair(s, static_cast<uint64_t>(0)));
+		while (!stk.empty())
+		{
+			auto current = stk.top();
+			stk.pop();
+			auto found = seen.find(current.first);
+			if (found != seen.end())
+			{
+				if (found->second != current.second)
+				{
+					return false;
+				}
+				continue;
+			}
+			seen[current.first] = current.second;
+			reached.push_back(current);
+			auto& edges = nfa.getNeighbours(current.first);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				const Transition& t = e->getTransition();
+				if (t.getType() != Transition::EPSILON)
+				{
+					continue;
+				}
+				uint64_t slots = current.second;
+				if (t.getTag() >= 0)
+				{
+					slots |= static_cast<uint64_t>(1) << t.getTag();
+				}
+				stk.push(std::make_pair(e->getTo(), slots));
+			}
+		}
+		return true;
+	}
+
+	Automata nfa;
+	SymbolClasses classes;
+	size_t slotCount;
+	bool onePass;
+	std::vector<State> rowState;
+	std::vector<bool> accepting;
+	std::vector<uint64_t> matchSlots;
+	std::vector<Entry> table;
+};
+
+#endif
\ No newline at end of file
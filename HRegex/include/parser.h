@@ -289,13 +289,138 @@
 
 // ֻNFAʱҪwalkûvisitor pattern
 
+struct RequiredLiteral;
+struct Positions;
+class PositionBuilder;
+
 class ExpressionNode
 {
 public:
 	virtual void convertToNFA(Automata& nfa, State& s, State& e) const = 0;
+	// Glushkov construction, see PositionBuilder
+	virtual Positions convertToPositions(PositionBuilder& builder) const = 0;
+	// append the literal every match of the node starts with,
+	// return true if the node matches exactly that literal and nothing else
+	virtual bool literalPrefix(std::vector<UnicodeChar>&) const
+	{
+		return false;
+	}
+	// literals every match of the node contains
+	virtual void requiredLiterals(std::vector<RequiredLiteral>&) const
+	{
+	}
 };
 typedef std::shared_ptr<ExpressionNode> NodePtr;
 
+struct RequiredLiteral
+{
+	std::vector<UnicodeChar> literal;
+	// what a match holds before the literal, null if the literal is a prefix
+	NodePtr before;
+};
+
+// positions a match of a node can start and end with, in priority order
+struct Positions
+{
+	Positions()
+		: nullable(false)
+	{
+	}
+	// whether the node matches the empty string
+	bool nullable;
+	std::vector<State> first;
+	std::vector<State> last;
+};
+
+// Glushkov (position) automata : one state per character of the pattern
+// plus the start state, every edge into a position is labelled with the
+// transition of its character. Follow edges are added while the tree is
+// walked, so the result has no epsilon transition and no closure to
+// compute. Edges are added inner node first, a loop edge comes before
+// the edges leaving the loop (greedy), but captures are not recorded.
+class PositionBuilder
+{
+public:
+	PositionBuilder(Automata& automata)
+		: nfa(automata), round(0)
+	{
+		start = addPosition(Transition::EPSILON);
+	}
+
+	State addPosition(const Transition& t)
+	{
+		State p = nfa.generateState();
+		entering.push_back(t);
+		linked.push_back(0);
+		return p;
+	}
+
+	// every position of to may follow every position of from
+	// the positions p already leads to are stamped with a new round, so
+	// an edge is looked up in constant time
+	void follow(const std::vector<State>& from, const std::vector<State>& to)
+	{
+		for (auto p = from.begin(); p != from.end(); ++p)
+		{
+			++round;
+			auto& edges = nfa.getNeighbours(*p);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				linked[e->getTo()] = round;
+			}
+			for (auto q = to.begin(); q != to.end(); ++q)
+			{
+				if (linked[*q] != round)
+				{
+					linked[*q] = round;
+					nfa.addTransition(*p, *q, entering[*q]);
+				}
+			}
+		}
+	}
+
+	Positions concatenate(const Positions& a, const Positions& b)
+	{
+		follow(a.last, b.first);
+		Positions result;
+		result.nullable = a.nullable && b.nullable;
+		result.first = a.first;
+		if (a.nullable)
+		{
+			result.first.insert(result.first.end(), b.first.begin(), b.first.end());
+		}
+		result.last = b.last;
+		if (b.nullable)
+		{
+			result.last.insert(result.last.end(), a.last.begin(), a.last.end());
+		}
+		return result;
+	}
+
+	// link the start state to the positions of the whole pattern
+	void finish(const Positions& root)
+	{
+		follow(std::vector<State>(1, start), root.first);
+		nfa.setStart(start);
+		for (auto p = root.last.begin(); p != root.last.end(); ++p)
+		{
+			nfa.setTerminate(*p);
+		}
+		if (root.nullable)
+		{
+			nfa.setTerminate(start);
+		}
+	}
+
+private:
+	Automata& nfa;
+	State start;
+	std::vector<Transition> entering;
+	// round of follow in which a position was last linked to
+	std::vector<size_t> linked;
+	size_t round;
+};
+
 ///////////
 class CharNode : public ExpressionNode
 {
@@ -309,6 +434,18 @@ public:
 		e = nfa.generateState();
 		nfa.addTransition(s, e, ch);
 	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		Positions result;
+		result.first.push_back(builder.addPosition(ch));
+		result.last = result.first;
+		return result;
+	}
+	bool literalPrefix(std::vector<UnicodeChar>& prefix) const
+	{
+		prefix.push_back(ch);
+		return true;
+	}
 private:
 	UnicodeChar ch;
 };
@@ -326,6 +463,13 @@ public:
 		e = nfa.generateState();
 		nfa.addTransition(s, e, rangeSet);
 	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		Positions result;
+		result.first.push_back(builder.addPosition(rangeSet));
+		result.last = result.first;
+		return result;
+	}
 private:
 	RangeSet rangeSet;
 };
@@ -339,6 +483,13 @@ public:
 		e = nfa.generateState();
 		nfa.addTransition(s, e, Transition::WILDCARD);
 	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		Positions result;
+		result.first.push_back(builder.addPosition(Transition::WILDCARD));
+		result.last = result.first;
+		return result;
+	}
 };
 //////////////
 class KleenNode : public ExpressionNode
@@ -355,10 +506,18 @@ public:
 		child->convertToNFA(nfa, childS, childE);
 		s = nfa.generateState();
 		e = nfa.generateState();
+		// edge order is priority order : loop again before leaving (greedy)
 		nfa.addTransition(s, childS, Transition::EPSILON);
-		nfa.addTransition(childE, e, Transition::EPSILON);
-		nfa.addTransition(s, e, Transition::EPSILON);
 		nfa.addTransition(childE, childS, Transition::EPSILON);
+		nfa.addTransition(s, e, Transition::EPSILON);
+		nfa.addTransition(childE, e, Transition::EPSILON);
+	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		Positions result = child->convertToPositions(builder);
+		builder.follow(result.last, result.first);
+		result.nullable = true;
+		return result;
 	}
 private:
 	NodePtr child;
@@ -376,6 +535,12 @@ public:
 		child->convertToNFA(nfa, s, e);
 		nfa.addTransition(s, e, Transition::EPSILON);
 	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		Positions result = child->convertToPositions(builder);
+		result.nullable = true;
+		return result;
+	}
 private:
 	NodePtr child;
 };
@@ -395,6 +560,17 @@ public:
 		nfa.addTransition(childE, e, Transition::EPSILON);
 		nfa.addTransition(e, s, Transition::EPSILON);
 	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		Positions result = child->convertToPositions(builder);
+		builder.follow(result.last, result.first);
+		return result;
+	}
+	bool literalPrefix(std::vector<UnicodeChar>& prefix) const
+	{
+		child->literalPrefix(prefix);
+		return false;
+	}
 private:
 	NodePtr child;
 };
@@ -470,6 +646,40 @@ public:
 			throw ParseError();
 		}
 	}
+	// a copy of the child per repetition, like convertToNFA
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		if (maxCount != -1 && (minCount > maxCount || minCount < 0))
+		{
+			throw ParseError();
+		}
+		Positions result;
+		result.nullable = true;
+		for (int i = 0; i < minCount; ++i)
+		{
+			result = builder.concatenate(result, child->convertToPositions(builder));
+		}
+		if (maxCount == -1)
+		{
+			return builder.concatenate(result, KleenNode(child).convertToPositions(builder));
+		}
+		for (int i = minCount; i < maxCount; ++i)
+		{
+			result = builder.concatenate(result, OptionalNode(child).convertToPositions(builder));
+		}
+		return result;
+	}
+	bool literalPrefix(std::vector<UnicodeChar>& prefix) const
+	{
+		for (int i = 0; i < minCount; ++i)
+		{
+			if (!child->literalPrefix(prefix))
+			{
+				return false;
+			}
+		}
+		return minCount == maxCount;
+	}
 private:
 	bool chainConcatenation(Automata& nfa, int count, bool addEps, State& s, State& e) const
 	{
@@ -501,6 +711,41 @@ private:
 };
 
 
+// group k records its bounds in capture slots 2k and 2k+1
+class CaptureNode : public ExpressionNode
+{
+public:
+	CaptureNode(size_t idx, NodePtr n)
+		: index(idx), child(n)
+	{
+	}
+	void convertToNFA(Automata& nfa, State& s, State& e) const
+	{
+		State childS;
+		State childE;
+		child->convertToNFA(nfa, childS, childE);
+		s = nfa.generateState();
+		e = nfa.generateState();
+		nfa.addTransition(s, childS, Transition(Transition::EPSILON, static_cast<int>(2 * index)));
+		nfa.addTransition(childE, e, Transition(Transition::EPSILON, static_cast<int>(2 * index + 1)));
+	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		return child->convertToPositions(builder);
+	}
+	bool literalPrefix(std::vector<UnicodeChar>& prefix) const
+	{
+		return child->literalPrefix(prefix);
+	}
+	void requiredLiterals(std::vector<RequiredLiteral>& literals) const
+	{
+		child->requiredLiterals(literals);
+	}
+private:
+	size_t index;
+	NodePtr child;
+};
+
 class AlternateNode : public ExpressionNode
 {
 public:
@@ -521,6 +766,31 @@ public:
 		nfa.addTransition(leftE, e, Transition::EPSILON);
 		nfa.addTransition(rightE, e, Transition::EPSILON);
 	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		Positions result = left->convertToPositions(builder);
+		Positions other = right->convertToPositions(builder);
+		result.nullable = result.nullable || other.nullable;
+		result.first.insert(result.first.end(), other.first.begin(), other.first.end());
+		result.last.insert(result.last.end(), other.last.begin(), other.last.end());
+		return result;
+	}
+	// common prefix of both sides
+	bool literalPrefix(std::vector<UnicodeChar>& prefix) const
+	{
+		std::vector<UnicodeChar> leftPrefix;
+		std::vector<UnicodeChar> rightPrefix;
+		bool leftComplete = left->literalPrefix(leftPrefix);
+		bool rightComplete = right->literalPrefix(rightPrefix);
+		size_t common = 0;
+		while (common < leftPrefix.size() && common < rightPrefix.size() &&
+			leftPrefix[common] == rightPrefix[common])
+		{
+			++common;
+		}
+		prefix.insert(prefix.end(), leftPrefix.begin(), leftPrefix.begin() + common);
+		return leftComplete && rightComplete && leftPrefix == rightPrefix;
+	}
 private:
 	NodePtr left;
 	NodePtr right;
@@ -548,33 +818,130 @@ public:
 		}
 		nfa.addTransition(current, e, Transition::EPSILON);
 	}
+	Positions convertToPositions(PositionBuilder& builder) const
+	{
+		Positions result;
+		result.nullable = true;
+		for (auto i = siblings.begin(); i != siblings.end(); ++i)
+		{
+			result = builder.concatenate(result, (*i)->convertToPositions(builder));
+		}
+		return result;
+	}
+	bool literalPrefix(std::vector<UnicodeChar>& prefix) const
+	{
+		for (auto i = siblings.begin(); i != siblings.end(); ++i)
+		{
+			if (!(*i)->literalPrefix(prefix))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	// runs of consecutive literal siblings, and the literals required
+	// inside the other siblings (a group)
+	void requiredLiterals(std::vector<RequiredLiteral>& literals) const
+	{
+		RequiredLiteral current;
+		size_t runStart = 0;
+		for (size_t i = 0; i <= siblings.size(); ++i)
+		{
+			if (i != siblings.size() && siblings[i]->literalPrefix(current.literal))
+			{
+				continue;
+			}
+			// the run ends with the literal prefix of sibling i
+			if (!current.literal.empty())
+			{
+				current.before = firstSiblings(runStart, nullptr);
+				literals.push_back(current);
+			}
+			if (i != siblings.size())
+			{
+				std::vector<RequiredLiteral> inner;
+				siblings[i]->requiredLiterals(inner);
+				for (auto l = inner.begin(); l != inner.end(); ++l)
+				{
+					l->before = firstSiblings(i, l->before);
+					literals.push_back(*l);
+				}
+			}
+			current = RequiredLiteral();
+			runStart = i + 1;
+		}
+	}
 private:
+	// the first count siblings followed by tail (may be null)
+	NodePtr firstSiblings(size_t count, NodePtr tail) const
+	{
+		if (count == 0)
+		{
+			return tail;
+		}
+		auto head = std::make_shared<ConcatenateNode>();
+		head->siblings.assign(siblings.begin(), siblings.begin() + count);
+		if (tail)
+		{
+			head->siblings.push_back(tail);
+		}
+		return head;
+	}
 	std::vector<NodePtr> siblings;
 };
 
+// how Parser turns the syntax tree into an automata
+enum NFAConstruction
+{
+	// epsilon transitions around every node, captures are tagged
+	THOMPSON,
+	// no epsilon transition, one state per character (see PositionBuilder)
+	GLUSHKOV
+};
+
 template <EncodeType E>
 class Parser
 {
 public:
-	Parser(typename Encode<E>::PointerType input, Automata& nfa)
-		: reader(input)
+	Parser(typename Encode<E>::PointerType input, Automata& nfa,
+		NFAConstruction construction = THOMPSON)
+		: reader(input), captureCount(0)
 	{
 		nfa.clear();
 		if (reader.peek() == 0)
 		{
 			return;
 		}
-		auto ast = parseRE();
+		ast = parseRE();
 		if (reader.peek() != 0)
 		{
 			throw ParseError();
 		}
+		if (construction == GLUSHKOV)
+		{
+			PositionBuilder builder(nfa);
+			builder.finish(ast->convertToPositions(builder));
+			return;
+		}
 		State s;
 		State e;
 		ast->convertToNFA(nfa, s, e);
 		nfa.setStart(s);
 		nfa.setTerminate(e);
 	}
+
+	// syntax tree of the pattern, null for the empty pattern
+	NodePtr getAST() const
+	{
+		return ast;
+	}
+
+	// number of capture groups, numbered from 1 by their left parenthesis
+	size_t getCaptureCount() const
+	{
+		return captureCount;
+	}
+
 private:
 	NodePtr parseRE()
 	{
@@ -665,14 +1032,17 @@ private:
 			reader.next();
 			break;
 		case '(':
+		{
 			reader.next();
+			size_t index = ++captureCount;
 			p = parseRE();
 			if (reader.peek() != ')')
 			{
 				throw ParseError();
 			}
 			reader.next();
-			return p;
+			return std::make_shared<CaptureNode>(index, p);
+		}
 		case '\0': case '*': case '|':
 			throw ParseError();
 			break;
@@ -739,6 +1109,8 @@ private:
 		return;
 	}
 	StreamReader<E> reader;
+	NodePtr ast;
+	size_t captureCount;
 };
 
 
@@ -0,0 +1,221 @@
+#ifndef _HREG_PIKEVM_
+#define _HREG_PIKEVM_
+
+#include "parser.h"
+#include "utf8ranges.h"
+
+/*
+
+	Pike VM
+
+	Simulates the byte NFA of a pattern like Automata::simulate does, but
+	every thread carries its own capture slots : taking a tagged epsilon
+	transition (see CaptureNode) writes the current offset into the
+	slot of its tag. Threads are kept in priority order and a state is
+	only added once per step (by the highest priority thread reaching
+	it), which gives leftmost-first captures in O(n * m) time.
+
+	Both thread lists are sparse sets (see SparseSet) allocated once
+	with the VM, a run does not allocate.
+
+	Offsets are in bytes, group 0 is the whole match, a group that did
+	not take part in the match has both slots set to NONE.
+
+	! NOTE : the thread lists are reused by every run, a PikeVM must not
+	         be shared between threads
+
+*/
+
+class PikeVM
+{
+public:
+	enum : size_t { NONE = SIZE_MAX };
+
+	PikeVM(const char* pattern)
+	{
+		Automata codepoints;
+		Parser<UTF8> parser(pattern, codepoints);
+		nfa = UTF8Ranges::CompileToBytes(codepoints);
+		slotCount = 2 * (parser.getCaptureCount() + 1);
+		important.resize(nfa.size(), false);
+		for (State s = 0; s != nfa.size(); ++s)
+		{
+			auto& edges = nfa.getNeighbours(s);
+			important[s] = nfa.isTerminate(s) ||
+				std::find_if(edges.begin(), edges.end(), [](const Edge& e)
+			{
+				return e.getTransition().getType() != Transition::EPSILON;
+			}) != edges.end();
+		}
+		current.allocate(nfa.size(), slotCount);
+		next.allocate(nfa.size(), slotCount);
+		scratch.resize(slotCount);
+		best.resize(slotCount);
+	}
+
+	// number of groups, including group 0
+	size_t getGroupCount() const
+	{
+		return slotCount / 2;
+	}
+
+	// leftmost-first match in text[from, length)
+	// captures[2i] and captures[2i + 1] are the bounds of group i
+	bool find(const char* text, size_t length, std::vector<size_t>& captures, size_t from = 0)
+	{
+		return run(reinterpret_cast<const HRegexByte*>(text), length, from, false, captures);
+	}
+
+	// whether the whole text matches, with the captures of that match
+	bool match(const char* text, size_t length, std::vector<size_t>& captures)
+	{
+		return run(reinterpret_cast<const HRegexByte*>(text), length, 0, true, captures);
+	}
+
+private:
+	// the slots of the i-th thread inserted start at i * slotCount
+	struct ThreadList
+	{
+		void allocate(size_t states, size_t slotsPerThread)
+		{
+			threads.allocate(states);
+			slots.resize(states * slotsPerThread);
+		}
+		SparseSet threads;
+		std::vector<size_t> slots;
+	};
+
+	// a state to visit, or a slot value to put back
+	struct Frame
+	{
+		State state;
+		int tag;
+		size_t restore;
+		bool isRestore;
+	};
+
+	bool run(const HRegexByte* str, size_t length, size_t from, bool anchored,
+		std::vector<size_t>& captures)
+	{
+		bool matched = false;
+		current.threads.clear();
+		if (nfa.size() == 0 || from > length)
+		{
+			return false;
+		}
+		State start = nfa.getStart().last();
+		for (size_t pos = from; ; ++pos)
+		{
+			if (!matched && (!anchored || pos == from))
+			{
+				// a new thread, lowest priority
+				std::fill(scratch.begin(), scratch.end(), NONE);
+				scratch[0] = pos;
+				addThread(current, start, pos);
+			}
+			if (current.threads.isEmpty())
+			{
+				break;
+			}
+			next.threads.clear();
+			for (size_t i = 0; i != current.threads.size(); ++i)
+			{
+				State s = current.threads[i];
+				if (!important[s])
+				{
+					continue;
+				}
+				size_t* slots = &current.slots[i * slotCount];
+				if (nfa.isTerminate(s))
+				{
+					if (!anchored || pos == length)
+					{
+						std::copy(slots, slots + slotCount, best.begin());
+						best[1] = pos;
+						matched = true;
+						// lower priority threads are cut off
+						break;
+					}
+					continue;
+				}
+				if (pos == length)
+				{
+					continue;
+				}
+				auto& edges = nfa.getNeighbours(s);
+				for (auto e = edges.begin(); e != edges.end(); ++e)
+				{
+					const Transition& t = e->getTransition();
+					if (t.getType() != Transition::EPSILON && t.check(str[pos]))
+					{
+						std::copy(slots, slots + slotCount, scratch.begin());
+						addThread(next, e->getTo(), pos + 1);
+					}
+				}
+			}
+			std::swap(current, next);
+			if (pos == length)
+			{
+				break;
+			}
+		}
+		if (matched)
+		{
+			captures.assign(best.begin(), best.end());
+		}
+		return matched;
+	}
+
+	// follow epsilon transitions from s in priority order, updating the
+	// slots in scratch on tagged ones (restored on the way back)
+	void addThread(ThreadList& list, State s, size_t pos)
+	{
+		stk.clear();
+		stk.push_back({ s, -1, 0, false });
+		while (!stk.empty())
+		{
+			Frame f = stk.back();
+			stk.pop_back();
+			if (f.isRestore)
+			{
+				scratch[f.tag] = f.restore;
+				continue;
+			}
+			if (f.tag >= 0)
+			{
+				// entering a tagged edge
+				stk.push_back({ 0, f.tag, scratch[f.tag], true });
+				scratch[f.tag] = pos;
+			}
+			if (list.threads.contains(f.state))
+			{
+				continue;
+			}
+			size_t index = list.threads.insertNew(f.state);
+			if (important[f.state])
+			{
+				std::copy(scratch.begin(), scratch.end(), list.slots.begin() + index * slotCount);
+			}
+			auto& edges = nfa.getNeighbours(f.state);
+			for (auto e = edges.rbegin(); e != edges.rend(); ++e)
+			{
+				const Transition& t = e->getTransition();
+				if (t.getType() == Transition::EPSILON)
+				{
+					stk.push_back({ e->getTo(), t.getTag(), 0, false });
+				}
+			}
+		}
+	}
+
+	Automata nfa;
+	size_t slotCount;
+	std::vector<bool> important;
+	ThreadList current;
+	ThreadList next;
+	std::vector<size_t> scratch;
+	std::vector<size_t> best;
+	std::vector<Frame> stk;
+};
+
+#endif
\ No newline at end of file
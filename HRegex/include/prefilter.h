@@ -0,0 +1,367 @@
+#ifndef _HREG_PREFILTER_
+#define _HREG_PREFILTER_
+
+#include <cstring>
+#include "parser.h"
+#include "utf8ranges.h"
+#include "simplifier.h"
+#include "densedfa.h"
+
+/*
+
+	Literal prefilter
+
+	Picks one literal every match contains (see
+	ExpressionNode::requiredLiterals), preferring the one whose rarest
+	byte is the least frequent in usual text, and finds its occurrences
+	with memchr on that byte. From an occurrence at h, the leftmost
+	position a match can start at is :
+
+	- h - maxLength(P) when the part P of the pattern before the
+	  literal is bounded (0 for a literal prefix),
+	- the furthest start found by running the reverse DFA of P backward
+	  from h otherwise. This is only done when the literal holds a byte
+	  P never matches and cannot overlap itself, so a match can never
+	  span an earlier occurrence : \d+ms user=alice uses "ms user=alice".
+
+	Everything before that position can be skipped by the search.
+
+*/
+
+class LiteralPrefilter
+{
+public:
+	static const size_t UNBOUNDED = SIZE_MAX;
+	static const size_t REVERSE_STATE_LIMIT = 1024;
+
+	// the last occurrence found, reused while it is still ahead
+	struct Cursor
+	{
+		Cursor()
+			: valid(false), hit(0)
+		{
+		}
+		bool valid;
+		size_t hit;
+	};
+
+	// no prefilter
+	LiteralPrefilter()
+		: rareOffset(0), maxBefore(0)
+	{
+	}
+
+	LiteralPrefilter(NodePtr ast)
+		: rareOffset(0), maxBefore(0)
+	{
+		if (!ast)
+		{
+			return;
+		}
+		std::vector<RequiredLiteral> candidates;
+		ast->requiredLiterals(candidates);
+		int bestScore = 256;
+		for (auto c = candidates.begin(); c != candidates.end(); ++c)
+		{
+			std::string bytes = EncodeLiteral(c->literal);
+			size_t offset = RarestByte(bytes);
+			int score = ByteFrequency(bytes[offset]);
+			if (score > bestScore || (score == bestScore && bytes.size() <= literal.size()))
+			{
+				continue;
+			}
+			size_t bound = 0;
+			std::unique_ptr<DenseDFA> reversed;
+			if (c->before)
+			{
+				Automata before = Compile(c->before);
+				bound = MaxLength(before);
+				if (bound == UNBOUNDED)
+				{
+					if (!HasForeignByte(before, bytes) || HasBorder(bytes))
+					{
+						continue;
+					}
+					try
+					{
+						reversed.reset(new DenseDFA(Simplifier::ReverseDFA(before, REVERSE_STATE_LIMIT)));
+					}
+					catch (const TooManyStatesError&)
+					{
+						continue;
+					}
+				}
+			}
+			literal = bytes;
+			rareOffset = offset;
+			maxBefore = bound;
+			beforeReverse = std::move(reversed);
+			bestScore = score;
+		}
+	}
+
+	bool isEmpty() const
+	{
+		return literal.empty();
+	}
+
+	// the literal searched for, in UTF-8
+	const std::string& getLiteral() const
+	{
+		return literal;
+	}
+
+	// smallest position >= from a match may start at, length if none
+	// ! NOTE : successive calls sharing a cursor must not decrease from
+	size_t nextStart(const HRegexByte* str, size_t from, size_t length, Cursor& cursor) const
+	{
+		size_t searchFrom = from;
+		while (true)
+		{
+			if (!cursor.valid || cursor.hit < searchFrom)
+			{
+				cursor.hit = findLiteral(str, searchFrom, length);
+				cursor.valid = true;
+			}
+			size_t hit = cursor.hit;
+			if (hit == length)
+			{
+				return length;
+			}
+			if (!beforeReverse)
+			{
+				return hit - from > maxBefore ? hit - maxBefore : from;
+			}
+			// furthest position the part before the literal reaches back to
+			size_t start = hit;
+			DenseDFA::DenseState current = beforeReverse->getStart();
+			bool found = beforeReverse->isAccepting(current);
+			for (size_t i = hit; i > from; --i)
+			{
+				current = beforeReverse->next(current, str[i - 1]);
+				if (current == DenseDFA::DEAD)
+				{
+					break;
+				}
+				if (beforeReverse->isAccepting(current))
+				{
+					start = i - 1;
+					found = true;
+				}
+			}
+			if (found)
+			{
+				return start;
+			}
+			searchFrom = hit + 1;
+		}
+	}
+
+	// rough frequency of a byte in text and logs, higher is more common
+	static int ByteFrequency(HRegexByte b)
+	{
+		static const char lower[] = "etaoinsrhldcumfpgwybvkxjqz";
+		static const char upper[] = "ETAOINSRHLDCUMFPGWYBVKXJQZ";
+		static const char digits[] = "0123456789";
+		static const char punctuation[] = "\n.,/-:=_\"'()\t";
+		const char* found;
+		if (b == ' ')
+		{
+			return 255;
+		}
+		if (b == 0)
+		{
+			return 10;
+		}
+		if ((found = strchr(lower, b)) != nullptr)
+		{
+			return 250 - 4 * static_cast<int>(found - lower);
+		}
+		if ((found = strchr(digits, b)) != nullptr)
+		{
+			return 190 - 3 * static_cast<int>(found - digits);
+		}
+		if ((found = strchr(punctuation, b)) != nullptr)
+		{
+			return 200 - 5 * static_cast<int>(found - punctuation);
+		}
+		if ((found = strchr(upper, b)) != nullptr)
+		{
+			return 130 - 2 * static_cast<int>(found - upper);
+		}
+		if (b >= 0x80 && b < 0xc0)
+		{
+			// UTF-8 continuation bytes
+			return 90;
+		}
+		if (b >= 0x80)
+		{
+			return 60;
+		}
+		if (b >= 0x20 && b < 0x7f)
+		{
+			return 80;
+		}
+		return 20;
+	}
+
+private:
+	// first occurrence of the literal at or after from, length if none
+	size_t findLiteral(const HRegexByte* str, size_t from, size_t length) const
+	{
+		size_t n = literal.size();
+		HRegexByte rare = static_cast<HRegexByte>(literal[rareOffset]);
+		while (from + n <= length)
+		{
+			const void* found = memchr(str + from + rareOffset, rare, length - from - n + 1);
+			if (found == nullptr)
+			{
+				break;
+			}
+			size_t position = static_cast<const HRegexByte*>(found) - str - rareOffset;
+			if (memcmp(str + position, literal.data(), n) == 0)
+			{
+				return position;
+			}
+			from = position + 1;
+		}
+		return length;
+	}
+
+	static std::string EncodeLiteral(const std::vector<UnicodeChar>& chars)
+	{
+		std::string bytes;
+		for (auto i = chars.begin(); i != chars.end(); ++i)
+		{
+			HRegexByte encoded[4];
+			size_t n = UTF8Ranges::Encode(*i, encoded);
+			bytes.append(reinterpret_cast<const char*>(encoded), n);
+		}
+		return bytes;
+	}
+
+	static size_t RarestByte(const std::string& bytes)
+	{
+		size_t rarest = 0;
+		for (size_t i = 1; i < bytes.size(); ++i)
+		{
+			if (ByteFrequency(bytes[i]) < ByteFrequency(bytes[rarest]))
+			{
+				rarest = i;
+			}
+		}
+		return rarest;
+	}
+
+	static Automata Compile(NodePtr node)
+	{
+		Automata nfa;
+		State s;
+		State e;
+		node->convertToNFA(nfa, s, e);
+		nfa.setStart(s);
+		nfa.setTerminate(e);
+		return UTF8Ranges::CompileToBytes(nfa);
+	}
+
+	// length in bytes of the longest match, UNBOUNDED if the automata loops
+	static size_t MaxLength(const Automata& a)
+	{
+		enum { WHITE, GREY, BLACK };
+		std::vector<int> color(a.size(), WHITE);
+		std::vector<size_t> longest(a.size(), 0);
+		std::stack<std::pair<State, size_t>> stk;
+		auto starts = a.getStart();
+		size_t result = 0;
+		for (auto i = starts.begin(); i != starts.end(); ++i)
+		{
+			if (color[*i] == WHITE)
+			{
+				color[*i] = GREY;
+				stk.push(std::make_pair(*i, 0));
+			}
+			while (!stk.empty())
+			{
+				State s = stk.top().first;
+				auto& edges = a.getNeighbours(s);
+				if (stk.top().second == edges.size())
+				{
+					// every successor is done
+					for (auto e = edges.begin(); e != edges.end(); ++e)
+					{
+						size_t step = e->getTransition().getType() == Transition::EPSILON ? 0 : 1;
+						longest[s] = std::max(longest[s], longest[e->getTo()] + step);
+					}
+					color[s] = BLACK;
+					stk.pop();
+					continue;
+				}
+				State t = edges[stk.top().second++].getTo();
+				if (color[t] == GREY)
+				{
+					return UNBOUNDED;
+				}
+				if (color[t] == WHITE)
+				{
+					color[t] = GREY;
+					stk.push(std::make_pair(t, 0));
+				}
+			}
+			result = std::max(result, longest[*i]);
+		}
+		return result;
+	}
+
+	// whether the literal holds a byte no transition of a accepts
+	static bool HasForeignByte(const Automata& a, const std::string& bytes)
+	{
+		bool used[256] = { false };
+		for (State s = 0; s != a.size(); ++s)
+		{
+			auto& edges = a.getNeighbours(s);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				Transition t = e->getTransition();
+				if (t.getType() == Transition::EPSILON)
+				{
+					continue;
+				}
+				for (UnicodeChar b = 0; b != 256; ++b)
+				{
+					used[b] = used[b] || t.check(b);
+				}
+			}
+		}
+		return std::find_if(bytes.begin(), bytes.end(), [&](char b)
+		{
+			return !used[static_cast<HRegexByte>(b)];
+		}) != bytes.end();
+	}
+
+	// whether a proper prefix of the literal is also a suffix of it,
+	// i.e. two occurrences can overlap
+	static bool HasBorder(const std::string& bytes)
+	{
+		std::vector<size_t> failure(bytes.size() + 1, 0);
+		for (size_t i = 1, k = 0; i < bytes.size(); ++i)
+		{
+			while (k > 0 && bytes[i] != bytes[k])
+			{
+				k = failure[k];
+			}
+			if (bytes[i] == bytes[k])
+			{
+				++k;
+			}
+			failure[i + 1] = k;
+		}
+		return failure[bytes.size()] > 0;
+	}
+
+	std::string literal;
+	size_t rareOffset;
+	size_t maxBefore;
+	std::unique_ptr<DenseDFA> beforeReverse;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#ifndef _HREG_REGEXSET_
+#define _HREG_REGEXSET_
+
+#include "parser.h"
+#include "utf8ranges.h"
+#include "simplifier.h"
+#include "densedfa.h"
+
+/*
+
+	Multi-pattern matching
+
+	Every pattern is compiled to a byte NFA, and all of them are joined
+	behind a single .* loop into one NFA whose terminate states are
+	labelled with the index of their pattern. That NFA is determinized
+	and minimized once (both keep the labels apart), so a single pass
+	over the text tells which patterns match somewhere in it, however
+	many patterns there are.
+
+	! NOTE : the DFA is built eagerly, a large set of patterns with
+	         many unbounded repetitions can take long to compile
+
+*/
+
+class RegexSet
+{
+public:
+	RegexSet(const std::vector<std::string>& patterns)
+		: count(patterns.size()), dfa(Compile(patterns))
+	{
+	}
+
+	// number of patterns
+	size_t size() const
+	{
+		return count;
+	}
+
+	// indices of the patterns matching somewhere in text, ascending
+	std::vector<size_t> matches(const char* text, size_t length) const
+	{
+		std::vector<bool> matched(count, false);
+		std::vector<size_t> result;
+		DenseDFA::DenseState current = dfa.getStart();
+		collect(current, matched, result);
+		for (size_t i = 0; i < length && result.size() != count; ++i)
+		{
+			current = dfa.next(current, static_cast<HRegexByte>(text[i]));
+			if (current == DenseDFA::DEAD)
+			{
+				break;
+			}
+			collect(current, matched, result);
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	// whether any pattern matches, stop at the first match
+	bool isMatch(const char* text, size_t length) const
+	{
+		DenseDFA::DenseState current = dfa.getStart();
+		for (size_t i = 0; i < length && !dfa.isAccepting(current); ++i)
+		{
+			current = dfa.next(current, static_cast<HRegexByte>(text[i]));
+			if (current == DenseDFA::DEAD)
+			{
+				return false;
+			}
+		}
+		return dfa.isAccepting(current);
+	}
+
+	// byte NFA of the union of the patterns (anchored), the terminate
+	// states of pattern i are labelled with i
+	static Automata Union(const std::vector<std::string>& patterns)
+	{
+		Automata all;
+		State start = all.generateState();
+		all.setStart(start);
+		for (size_t id = 0; id != patterns.size(); ++id)
+		{
+			Automata nfa;
+			Parser<UTF8>(patterns[id].c_str(), nfa);
+			nfa = UTF8Ranges::CompileToBytes(nfa);
+			State offset = all.size();
+			for (size_t i = 0; i != nfa.size(); ++i)
+			{
+				all.generateState();
+			}
+			for (State s = 0; s != nfa.size(); ++s)
+			{
+				auto& edges = nfa.getNeighbours(s);
+				for (auto e = edges.begin(); e != edges.end(); ++e)
+				{
+					all.addTransition(s + offset, e->getTo() + offset, e->getTransition());
+				}
+				if (nfa.isTerminate(s))
+				{
+					all.setTerminate(s + offset, id);
+				}
+			}
+			auto starts = nfa.getStart();
+			for (auto i = starts.begin(); i != starts.end(); ++i)
+			{
+				all.addTransition(start, *i + offset, Transition::EPSILON);
+			}
+		}
+		return all;
+	}
+
+	// number of DFA states, including the dead state
+	size_t getStateCount() const
+	{
+		return dfa.size();
+	}
+
+private:
+	void collect(DenseDFA::DenseState s, std::vector<bool>& matched, std::vector<size_t>& result) const
+	{
+		if (!dfa.isAccepting(s))
+		{
+			return;
+		}
+		auto& labels = dfa.getLabels(s);
+		for (auto i = labels.begin(); i != labels.end(); ++i)
+		{
+			if (!matched[*i])
+			{
+				matched[*i] = true;
+				result.push_back(*i);
+			}
+		}
+	}
+
+	static Automata Compile(const std::vector<std::string>& patterns)
+	{
+		Automata all = Union(patterns);
+		State start = all.getStart().last();
+		all.addTransition(start, start, Transition::WILDCARD);
+		return Simplifier::Minimize(Simplifier::NFAToDFA(all, SymbolClasses(all)));
+	}
+
+	size_t count;
+	DenseDFA dfa;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,268 @@
+#ifndef _HREG_SEARCH_
+#define _HREG_SEARCH_
+
+#include "parser.h"
+#include "utf8ranges.h"
+#include "simplifier.h"
+#include "lazydfa.h"
+#include "densedfa.h"
+#include "prefilter.h"
+
+/*
+
+	Unanchored search
+
+	Finds the leftmost-first matches of a UTF-8 pattern inside a UTF-8
+	buffer, every offset is in bytes. A search is two linear scans :
+
+	1. forward, with the pattern behind an implicit lowest priority .*?
+	   loop. The last accepting position before the DFA dies is the end
+	   of the leftmost-first match.
+	2. backward from that end, with the minimal DFA of the reversed
+	   language (Simplifier::ReverseDFA). The furthest accepting position
+	   is the start of the match.
+
+	The forward DFA is built lazily (see LazyDFA). The reverse one is
+	compiled up front to a DenseDFA, unless it would need more than
+	REVERSE_STATE_LIMIT states : it is then built lazily too.
+
+	When every match contains a literal (GET /api/ for GET /api/\d+),
+	the forward scan does not feed the DFA byte by byte while it sits in
+	its start state : it jumps straight to the next position a match can
+	start at (see LiteralPrefilter).
+
+	! NOTE : a Searcher caches DFA states while searching, it must not be
+	         shared between threads
+
+*/
+
+struct Match
+{
+	size_t start;
+	size_t end;
+
+	size_t length() const
+	{
+		return end - start;
+	}
+
+	bool operator==(const Match& other) const
+	{
+		return start == other.start && end == other.end;
+	}
+};
+
+class Searcher
+{
+public:
+	static const size_t REVERSE_STATE_LIMIT = 4096;
+
+	Searcher(const char* pattern, size_t cacheBudget = LazyDFA::DEFAULT_BUDGET)
+		: Searcher(Compile(pattern), cacheBudget)
+	{
+	}
+
+	// find the leftmost-first match in text[from, length)
+	bool find(const char* text, size_t length, Match& result, size_t from = 0)
+	{
+		const HRegexByte* str = reinterpret_cast<const HRegexByte*>(text);
+		if (from > length)
+		{
+			return false;
+		}
+		size_t end = 0;
+		bool found = false;
+		LiteralPrefilter::Cursor cursor;
+		LazyDFA::CachedState current = forward.getStart();
+		if (forward.isAccepting(current))
+		{
+			end = from;
+			found = true;
+		}
+		for (size_t i = from; i < length; ++i)
+		{
+			if (!prefilter.isEmpty() && forward.isStart(current))
+			{
+				// no thread has started yet, skip to the next candidate
+				i = prefilter.nextStart(str, i, length, cursor);
+				if (i == length)
+				{
+					break;
+				}
+			}
+			current = forward.next(current, str[i]);
+			if (current == LazyDFA::DEAD)
+			{
+				break;
+			}
+			if (forward.isAccepting(current))
+			{
+				end = i + 1;
+				found = true;
+			}
+		}
+		if (!found)
+		{
+			return false;
+		}
+		size_t start = denseReverse ?
+			FindStart(*denseReverse, str, from, end) :
+			FindStart(reverse, str, from, end);
+		result.start = start;
+		result.end = end;
+		return true;
+	}
+
+	// all non-overlapping matches, left to right
+	std::vector<Match> findAll(const char* text, size_t length)
+	{
+		std::vector<Match> result;
+		MatchIterator it(*this, text, length);
+		Match m;
+		while (it.next(m))
+		{
+			result.push_back(m);
+		}
+		return result;
+	}
+
+	class MatchIterator
+	{
+	public:
+		MatchIterator(Searcher& s, const char* str, size_t len)
+			: searcher(s), text(str), length(len), position(0)
+		{
+		}
+
+		bool next(Match& m)
+		{
+			if (position > length || !searcher.find(text, length, m, position))
+			{
+				position = length + 1;
+				return false;
+			}
+			if (m.end > m.start)
+			{
+				position = m.end;
+			}
+			else
+			{
+				// step over the next character after an empty match
+				position = m.end + 1;
+				while (position < length &&
+					(static_cast<HRegexByte>(text[position]) & 0xc0) == 0x80)
+				{
+					++position;
+				}
+			}
+			return true;
+		}
+
+	private:
+		Searcher& searcher;
+		const char* text;
+		size_t length;
+		size_t position;
+	};
+
+	MatchIterator iterate(const char* text, size_t length)
+	{
+		return MatchIterator(*this, text, length);
+	}
+
+private:
+	// the byte automata of a pattern and its syntax tree
+	struct Compiled
+	{
+		Automata bytes;
+		NodePtr ast;
+	};
+
+	Searcher(const Compiled& compiled, size_t cacheBudget)
+		: forward(Unanchored(compiled.bytes), LEFTMOST_FIRST, cacheBudget),
+		  reverse(compiled.bytes.reverseEdges(), ALL_MATCHES, cacheBudget),
+		  prefilter(compiled.ast)
+	{
+		try
+		{
+			denseReverse.reset(new DenseDFA(Simplifier::ReverseDFA(compiled.bytes, REVERSE_STATE_LIMIT)));
+		}
+		catch (const TooManyStatesError&)
+		{
+			// keep the lazy one
+		}
+	}
+
+	// run the reverse DFA from end back to from, return the furthest
+	// position it accepts at
+	template <typename DFA>
+	static size_t FindStart(DFA& dfa, const HRegexByte* str, size_t from, size_t end)
+	{
+		size_t start = end;
+		auto current = dfa.getStart();
+		for (size_t i = end; i > from; --i)
+		{
+			current = dfa.next(current, str[i - 1]);
+			if (current == DFA::DEAD)
+			{
+				break;
+			}
+			if (dfa.isAccepting(current))
+			{
+				start = i - 1;
+			}
+		}
+		return start;
+	}
+
+	static Compiled Compile(const char* pattern)
+	{
+		Automata nfa;
+		Parser<UTF8> parser(pattern, nfa);
+		Compiled result;
+		result.bytes = UTF8Ranges::CompileToBytes(nfa);
+		result.ast = parser.getAST();
+		return result;
+	}
+
+	// prepend the .*? loop, it must come after the pattern in edge order
+	// so a thread restarted later never beats one started earlier
+	static Automata Unanchored(const Automata& bytes)
+	{
+		Automata result;
+		for (size_t i = 0; i != bytes.size(); ++i)
+		{
+			result.generateState();
+		}
+		for (State s = 0; s != bytes.size(); ++s)
+		{
+			auto& edges = bytes.getNeighbours(s);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				result.addTransition(s, e->getTo(), e->getTransition());
+			}
+			if (bytes.isTerminate(s))
+			{
+				result.setTerminate(s);
+			}
+		}
+		State restart = result.generateState();
+		State skip = result.generateState();
+		auto starts = bytes.getStart();
+		for (auto i = starts.begin(); i != starts.end(); ++i)
+		{
+			result.addTransition(restart, *i, Transition::EPSILON);
+		}
+		result.addTransition(restart, skip, Transition::EPSILON);
+		result.addTransition(skip, restart, Transition::WILDCARD);
+		result.setStart(restart);
+		return result;
+	}
+
+	LazyDFA forward;
+	LazyDFA reverse;
+	std::unique_ptr<DenseDFA> denseReverse;
+	LiteralPrefilter prefilter;
+};
+
+#endif
\ No newline at end of file
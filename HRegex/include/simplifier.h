@@ -2,12 +2,37 @@
 #define _HREG_SIMPLIFIER_
 
 #include "automata.h"
+#include "alphabet.h"
 
 class Simplifier
 {
 public:
+	// number of NFA states up to which subsets are DenseBitSets rather
+	// than SortedVectorSets (see NFAToDFA) : their bits fit in the set
+	// itself, as cheap to copy as a small sorted set and faster when
+	// subsets are large. Past that sorted sets win, most subsets of a
+	// large NFA (a RegexSet of literals) hold a few states
+	enum : size_t { DENSE_SUBSET_STATES = 64 * DenseBitSet::INLINE_WORDS };
+
 	// convert NFA to DFA using subset construction algorithm
 	// see http://en.wikipedia.org/wiki/Powerset_construction
+	// every subset is moved on the disjoint intervals of its transitions
+	// (see Automata::getAtoms), so overlapping transitions ('a' and . for
+	// example) are split correctly, intervals leading to the same subset
+	// share one edge
+	// the state set policy is chosen by the size of the NFA
+	static Automata NFAToDFA(const Automata& nfa)
+	{
+		if (nfa.size() <= DENSE_SUBSET_STATES)
+		{
+			return NFAToDFA<DenseBitSet>(nfa);
+		}
+		return NFAToDFA<SortedVectorSet<State>>(nfa);
+	}
+
+	// the same with subsets of type StateSet : SortedVectorSet<State> or
+	// DenseBitSet
+	template <typename StateSet>
 	static Automata NFAToDFA(const Automata& nfa)
 	{
 		Automata dfa;
@@ -15,154 +40,569 @@ public:
 		{
 			return dfa;
 		}
-		std::map<SortedVectorSet<State>, State> setToState;
-		SortedVectorSet<State> start = nfa.getStart();
-		start = nfa.epsilonClosure(start);
+		EpsilonClosures closures(nfa);
+		StateSet terminates(nfa.getTerminate().begin(), nfa.getTerminate().end());
+		// subset i is DFA state i, every subset is stored once
+		SetInterner<State> subsets;
+		StateSet start = closures.closure(StateSet(nfa.getStart().begin(), nfa.getStart().end()));
+		subsets.intern(start);
 		State dfaStart = dfa.generateState();
-		setToState[start] = dfaStart;
 		dfa.setStart(dfaStart);
-		if (nfa.containsTerminate(start))
+		if (start.intersects(terminates))
 		{
-			dfa.setTerminate(dfaStart);
+			SetTerminate(dfa, dfaStart, nfa.getLabels(start));
 		}
-		std::stack<SortedVectorSet<State>> stk;
-		stk.push(start);
+		// subsets to move on, kept in the pool only
+		std::stack<State> stk;
+		stk.push(dfaStart);
 		while (!stk.empty())
 		{
-			auto current = stk.top();
-			auto currentState = setToState[current];
+			State currentState = stk.top();
 			stk.pop();
-			auto transitions = nfa.getNoneEpsilonTransitions(current);
-			for (auto t = transitions.begin(); t != transitions.end(); ++t)
+			StateSet current(subsets.begin(currentState), subsets.end(currentState));
+			auto atoms = nfa.getAtoms(current);
+			// destination -> intervals, in order of first appearance
+			std::vector<std::pair<State, std::vector<Range>>> edges;
+			for (auto atom = atoms.begin(); atom != atoms.end(); ++atom)
 			{
-				auto next = nfa.move(current, *t);
-				next = nfa.epsilonClosure(next);
-				auto result = setToState.find(next);
-				State dest;
-				if (result != setToState.end())
+				auto next = closures.closure(nfa.move(current, atom->lower));
+				auto interned = subsets.intern(next);
+				State dest = interned.first;
+				if (interned.second)
 				{
-					dest = result->second;
+					dfa.generateState();
+					if (next.intersects(terminates))
+					{
+						SetTerminate(dfa, dest, nfa.getLabels(next));
+					}
+					stk.push(dest);
+				}
+				auto edge = std::find_if(edges.begin(), edges.end(),
+					[&](const std::pair<State, std::vector<Range>>& e)
+				{
+					return e.first == dest;
+				});
+				if (edge == edges.end())
+				{
+					edges.push_back(std::make_pair(dest, std::vector<Range>(1, *atom)));
+				}
+				else if (edge->second.back().upper + 1 == atom->lower)
+				{
+					edge->second.back().upper = atom->upper;
 				}
 				else
 				{
-					dest = dfa.generateState();
-					setToState[next] = dest;
-					if (nfa.containsTerminate(next))
+					edge->second.push_back(*atom);
+				}
+			}
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				RangeSet st;
+				for (auto r = e->second.begin(); r != e->second.end(); ++r)
+				{
+					st.insert(*r);
+				}
+				dfa.addTransition(currentState, e->first, ClassTransition(st));
+			}
+		}
+		return dfa;
+	}
+
+	// subset construction over symbol classes : every class is moved on
+	// as a whole, so overlapping transitions ('a' and . for example) are
+	// split correctly and the result is always deterministic
+	// the state set policy is chosen by the size of the NFA
+	// throw TooManyStatesError when more than maxStates states are needed
+	static Automata NFAToDFA(const Automata& nfa, const SymbolClasses& classes,
+		size_t maxStates = SIZE_MAX)
+	{
+		if (nfa.size() <= DENSE_SUBSET_STATES)
+		{
+			return NFAToDFA<DenseBitSet>(nfa, classes, maxStates);
+		}
+		return NFAToDFA<SortedVectorSet<State>>(nfa, classes, maxStates);
+	}
+
+	template <typename StateSet>
+	static Automata NFAToDFA(const Automata& nfa, const SymbolClasses& classes,
+		size_t maxStates = SIZE_MAX)
+	{
+		Automata dfa;
+		if (nfa.size() == 0)
+		{
+			return dfa;
+		}
+		std::vector<Transition> labels;
+		for (size_t c = 0; c != classes.size(); ++c)
+		{
+			labels.push_back(ClassTransition(classes.getRangeSet(c)));
+		}
+		EpsilonClosures closures(nfa);
+		StateSet terminates(nfa.getTerminate().begin(), nfa.getTerminate().end());
+		// subset i is DFA state i, every subset is stored once
+		SetInterner<State> subsets;
+		StateSet start = closures.closure(StateSet(nfa.getStart().begin(), nfa.getStart().end()));
+		subsets.intern(start);
+		State dfaStart = dfa.generateState();
+		dfa.setStart(dfaStart);
+		if (start.intersects(terminates))
+		{
+			SetTerminate(dfa, dfaStart, nfa.getLabels(start));
+		}
+		// subsets to move on, kept in the pool only
+		std::stack<State> stk;
+		stk.push(dfaStart);
+		while (!stk.empty())
+		{
+			State currentState = stk.top();
+			stk.pop();
+			StateSet current(subsets.begin(currentState), subsets.end(currentState));
+			for (size_t c = 0; c != classes.size(); ++c)
+			{
+				auto next = nfa.move(current, classes.representative(c));
+				if (next.isEmpty())
+				{
+					continue;
+				}
+				next = closures.closure(next);
+				auto interned = subsets.intern(next);
+				State dest = interned.first;
+				if (interned.second)
+				{
+					if (dfa.size() == maxStates)
 					{
-						dfa.setTerminate(dest);
+						throw TooManyStatesError();
 					}
-					stk.push(next);
+					dfa.generateState();
+					if (next.intersects(terminates))
+					{
+						SetTerminate(dfa, dest, nfa.getLabels(next));
+					}
+					stk.push(dest);
 				}
-				dfa.addTransition(currentState, dest, *t);
+				dfa.addTransition(currentState, dest, labels[c]);
 			}
 		}
 		return dfa;
 	}
 
-	// minimize DFA using Hopcroft's algorithm
+	// minimal DFA of the reversed language : it reads a match backward,
+	// from its end to its start
+	static Automata ReverseDFA(const Automata& nfa, size_t maxStates = SIZE_MAX)
+	{
+		Automata reversed = nfa.reverseEdges();
+		SymbolClasses classes(reversed);
+		return Minimize(NFAToDFA(reversed, classes, maxStates));
+	}
+
+	// size (states * classes) and number of classes from which a
+	// complete DFA is minimized with Hopcroft's algorithm
+	enum : size_t { DENSE_MINIMIZE_CELLS = 65536, DENSE_MINIMIZE_CLASSES = 32 };
+
+	enum Minimizer
+	{
+		HOPCROFT,
+		VALMARI,
+		BRZOZOWSKI
+	};
+
+	// the minimizer fitting a DFA best, from the size and the density of
+	// its transition function (measured by Experiment/minimizers.cpp) :
+	// Valmari & Lehtinen's work follows the transitions and wins on the
+	// partial DFAs we build, Hopcroft's catches up on complete ones and
+	// wins when they are large and wide. Brzozowski's is never the
+	// fastest on a DFA, it is there for NFAs
+	static Minimizer ChooseMinimizer(const Automata& dfa)
+	{
+		return ChooseMinimizer(dfa, SymbolClasses(dfa));
+	}
+
+	// classes are the SymbolClasses of dfa
+	static Minimizer ChooseMinimizer(const Automata& dfa, const SymbolClasses& classes)
+	{
+		// density over the classes some transition is on
+		std::vector<bool> used(classes.size(), false);
+		size_t transitions = 0;
+		for (State s = 0; s != dfa.size(); ++s)
+		{
+			auto& edges = dfa.getNeighbours(s);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				auto covered = classes.classesOf(e->getTransition());
+				for (auto c = covered.begin(); c != covered.end(); ++c)
+				{
+					used[*c] = true;
+				}
+				transitions += covered.size();
+			}
+		}
+		size_t width = std::count(used.begin(), used.end(), true);
+		size_t cells = dfa.size() * width;
+		// at least 95% of a large and wide table filled
+		if (width >= DENSE_MINIMIZE_CLASSES && cells >= DENSE_MINIMIZE_CELLS && transitions * 20 >= cells * 19)
+		{
+			return HOPCROFT;
+		}
+		return VALMARI;
+	}
+
+	// minimal DFA, using the given minimizer
+	// throw IllegalStateError for BRZOZOWSKI when terminate states have
+	// different labels
+	static Automata Minimize(const Automata& dfa, Minimizer minimizer)
+	{
+		return Minimize(dfa, minimizer, SymbolClasses(dfa));
+	}
+
+	// classes are the SymbolClasses of dfa
+	static Automata Minimize(const Automata& dfa, Minimizer minimizer, const SymbolClasses& classes)
+	{
+		switch (minimizer)
+		{
+		case VALMARI:
+			return ValmariMinimize(dfa, classes);
+		case BRZOZOWSKI:
+			return BrzozowskiMinimize(dfa);
+		default:
+			return MinimizeDFA(dfa, classes);
+		}
+	}
+
+	// the classes are computed once, for the choice and the minimizer
+	static Automata Minimize(const Automata& dfa)
+	{
+		SymbolClasses classes(dfa);
+		return Minimize(dfa, ChooseMinimizer(dfa, classes), classes);
+	}
+
+	// minimize DFA using Hopcroft's algorithm, in O(m log n)
 	// see http://en.wikipedia.org/wiki/DFA_minimization
-	// ! NOTE : A straight-forward implementation, it's not efficient for now
+	// symbols are the classes of SymbolClasses, a splitter (block, class)
+	// marks the sources of the transitions entering the block on the
+	// class. Every initial block is a splitter for every class, which
+	// keeps "process the smaller half" correct for partial transition
+	// functions, no dead state is added
 	static Automata MinimizeDFA(const Automata& dfa)
 	{
-		Automata reversed = dfa.reverseEdges();
-		SortedVectorSet<SortedVectorSet<State>> workList;
-		std::vector<SortedVectorSet<State>> groups;
-		// initialize worklist and group set
-		auto terminates = dfa.getTerminate();
-		auto rest = dfa.getAllStates() - terminates;
-		groups.push_back(terminates);
-		groups.push_back(rest);
-		workList.insert(terminates);
-		workList.insert(rest);
-
-		while (!workList.isEmpty())
-		{
-			auto current = workList.last();
-			workList.popBack();
-			auto inEdges = reversed.getNoneEpsilonTransitions(current);
-			for (auto i = inEdges.begin(); i != inEdges.end(); ++i)
-			{
-				auto projection = reversed.move(current, *i);
-				// new groups to be added in next iteration
-				// (cannot be directly inserted into groups vector, because
-				//  that will invalidate the vector iterator)
-				std::vector<SortedVectorSet<State>> added;
-				for (auto j = groups.begin(); j != groups.end(); )
-				{
-					auto intersection = projection && (*j);
-					auto restStates = (*j) - intersection;
-					if ((!intersection.isEmpty()) &&
-						(!restStates.isEmpty()))
-					{
-						added.push_back(intersection);
-						added.push_back(restStates);
-						if (workList.contains(*j))
-						{
-							workList.remove(*j);
-							workList.insert(intersection);
-							workList.insert(restStates);
-						}
-						else if (intersection.size() <= restStates.size())
-						{
-							workList.insert(intersection);
-						}
-						else
-						{
-							workList.insert(restStates);
-						}
-						j = groups.erase(j);
-					}
-					else
+		return MinimizeDFA(dfa, SymbolClasses(dfa));
+	}
+
+	// classes are the SymbolClasses of dfa
+	static Automata MinimizeDFA(const Automata& dfa, const SymbolClasses& classes)
+	{
+		size_t n = dfa.size();
+		if (n == 0)
+		{
+			return Automata();
+		}
+		size_t k = classes.size();
+		auto edges = ClassEdges(dfa, classes);
+
+		// transitions entering every state, sorted by class
+		std::sort(edges.begin(), edges.end(), [](const ClassEdge& a, const ClassEdge& b)
+		{
+			return a.head < b.head || (a.head == b.head && a.cls < b.cls);
+		});
+		std::vector<size_t> inStart(n + 1, 0);
+		for (auto e = edges.begin(); e != edges.end(); ++e)
+		{
+			++inStart[e->head + 1];
+		}
+		for (size_t i = 0; i != n; ++i)
+		{
+			inStart[i + 1] += inStart[i];
+		}
+
+		std::vector<size_t> keys;
+		size_t initial = InitialBlocks(dfa, keys);
+		RefinablePartition blocks(keys, initial);
+
+		// pending splitters (block, class)
+		std::vector<std::pair<size_t, size_t>> work;
+		for (size_t b = 0; b != initial; ++b)
+		{
+			for (size_t c = 0; c != k; ++c)
+			{
+				work.push_back(std::make_pair(b, c));
+			}
+		}
+		std::vector<State> sources;
+		while (!work.empty())
+		{
+			size_t splitter = work.back().first;
+			size_t cls = work.back().second;
+			work.pop_back();
+			// collect first, marking reorders the splitter itself
+			sources.clear();
+			for (auto t = blocks.begin(splitter); t != blocks.end(splitter); ++t)
+			{
+				auto range = std::equal_range(edges.begin() + inStart[*t], edges.begin() + inStart[*t + 1],
+					ClassEdge{ 0, cls, *t }, [](const ClassEdge& a, const ClassEdge& b)
+				{
+					return a.cls < b.cls;
+				});
+				for (auto e = range.first; e != range.second; ++e)
+				{
+					sources.push_back(e->tail);
+				}
+			}
+			for (auto s = sources.begin(); s != sources.end(); ++s)
+			{
+				blocks.mark(*s);
+			}
+			size_t before = blocks.size();
+			blocks.split();
+			// a new block is the smaller part : when the split block was
+			// a pending splitter, its index still names what is left of
+			// it, so only the new block is missing ; when it was not, the
+			// smaller half is enough (Hopcroft's "process the smaller half")
+			for (size_t b = before; b != blocks.size(); ++b)
+			{
+				for (size_t c = 0; c != k; ++c)
+				{
+					work.push_back(std::make_pair(b, c));
+				}
+			}
+		}
+		return Quotient(dfa, blocks);
+	}
+
+	// minimize DFA using Valmari & Lehtinen's algorithm, in O(m log n)
+	// see "Efficient Minimization of DFAs with Partial Transition
+	// Functions" (2008)
+	// the transitions are kept in a second refinable partition (by
+	// class at first), both partitions split each other in turn : a
+	// set of transitions splits the blocks by their tails, a new block
+	// splits the sets of transitions by their heads. There is no
+	// worklist of (block, class) pairs, the work is proportional to the
+	// transitions, which suits sparse transition functions
+	static Automata ValmariMinimize(const Automata& dfa)
+	{
+		return ValmariMinimize(dfa, SymbolClasses(dfa));
+	}
+
+	// classes are the SymbolClasses of dfa
+	static Automata ValmariMinimize(const Automata& dfa, const SymbolClasses& classes)
+	{
+		size_t n = dfa.size();
+		if (n == 0)
+		{
+			return Automata();
+		}
+		auto edges = ClassEdges(dfa, classes);
+
+		// transitions entering every state
+		std::vector<size_t> inStart(n + 1, 0);
+		std::vector<size_t> incoming(edges.size());
+		std::vector<size_t> cls;
+		for (auto e = edges.begin(); e != edges.end(); ++e)
+		{
+			++inStart[e->head + 1];
+			cls.push_back(e->cls);
+		}
+		for (size_t i = 0; i != n; ++i)
+		{
+			inStart[i + 1] += inStart[i];
+		}
+		{
+			std::vector<size_t> fill(inStart.begin(), inStart.end() - 1);
+			for (size_t t = 0; t != edges.size(); ++t)
+			{
+				incoming[fill[edges[t].head]++] = t;
+			}
+		}
+
+		std::vector<size_t> keys;
+		size_t initial = InitialBlocks(dfa, keys);
+		RefinablePartition blocks(keys, initial);
+		RefinablePartition cords(cls, classes.size());
+
+		// one initial block needs not split the transitions, the others
+		// and the classes do it already
+		size_t largest = 0;
+		for (size_t b = 1; b != initial; ++b)
+		{
+			if (blocks.setSize(b) > blocks.setSize(largest))
+			{
+				largest = b;
+			}
+		}
+		size_t b = 0;
+		for (size_t c = 0; c != cords.size(); ++c)
+		{
+			for (auto t = cords.begin(c); t != cords.end(c); ++t)
+			{
+				blocks.mark(edges[*t].tail);
+			}
+			blocks.split();
+			for (; b != blocks.size(); ++b)
+			{
+				if (b == largest)
+				{
+					continue;
+				}
+				for (auto s = blocks.begin(b); s != blocks.end(b); ++s)
+				{
+					for (size_t i = inStart[*s]; i != inStart[*s + 1]; ++i)
 					{
-						j++;
+						cords.mark(incoming[i]);
 					}
 				}
-				// update group
-				groups.insert(groups.end(), added.begin(), added.end());
+				cords.split();
 			}
 		}
-		// convert groups to new DFA
-		Automata minimized;
-		// remove empty group
-		groups.erase(std::remove_if(groups.begin(), groups.end(),
-		[&](const SortedVectorSet<State>& s) {
-			return s.isEmpty();
-		}), groups.end());
-		if (groups.empty())
+		return Quotient(dfa, blocks);
+	}
+
+	// minimize DFA using Brzozowski's algorithm : determinizing the
+	// reversed automata twice
+	// see "Canonical regular expressions and minimal state graphs for
+	// definite events" (1962)
+	// works on NFAs as well, but the subset construction is exponential
+	// in the worst case. Unlike the others the result has no state from
+	// which no terminate state is reachable
+	// throw IllegalStateError when terminate states have different labels
+	static Automata BrzozowskiMinimize(const Automata& dfa)
+	{
+		if (dfa.size() == 0)
 		{
-			return minimized;
+			return Automata();
 		}
-		// map each state to group index
-		std::vector<size_t> groupMap(dfa.size());
-		for (size_t i = 0; i != groups.size(); ++i)
+		// reversing loses the labels, which are the same everywhere
+		SortedVectorSet<size_t> labels;
+		bool labelled = false;
+		for (State s = 0; s != dfa.size(); ++s)
 		{
-			minimized.generateState();
+			if (!dfa.isTerminate(s))
+			{
+				continue;
+			}
+			auto current = dfa.getLabels(s);
+			if (labelled && current != labels)
+			{
+				throw IllegalStateError();
+			}
+			labels = current;
+			labelled = true;
 		}
-		for (size_t i = 0; i != groups.size(); ++i)
+		Automata reversed = NFAToDFA(dfa.reverseEdges());
+		Automata minimized = NFAToDFA(reversed.reverseEdges());
+		for (State s = 0; s != minimized.size(); ++s)
+		{
+			if (minimized.isTerminate(s))
+			{
+				SetTerminate(minimized, s, labels);
+			}
+		}
+		return minimized;
+	}
+
+private:
+	// a transition on one symbol class
+	struct ClassEdge
+	{
+		State tail;
+		size_t cls;
+		State head;
+	};
+
+	static std::vector<ClassEdge> ClassEdges(const Automata& dfa, const SymbolClasses& classes)
+	{
+		std::vector<ClassEdge> result;
+		for (State s = 0; s != dfa.size(); ++s)
 		{
-			for (auto j = groups[i].begin(); j != groups[i].end(); ++j)
+			auto& edges = dfa.getNeighbours(s);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
 			{
-				groupMap[*j] = i;
-				if (dfa.isTerminate(*j))
+				auto covered = classes.classesOf(e->getTransition());
+				for (auto c = covered.begin(); c != covered.end(); ++c)
 				{
-					minimized.setTerminate(i);
+					result.push_back(ClassEdge{ s, *c, e->getTo() });
 				}
-				if (dfa.isStart(*j))
+			}
+		}
+		return result;
+	}
+
+	// initial block of every state : terminate states are split by label
+	// set, returns the number of blocks (none of them empty)
+	// label sets are pooled, a state's set is looked up by hash and
+	// then known by its id
+	static size_t InitialBlocks(const Automata& dfa, std::vector<size_t>& keys)
+	{
+		SetInterner<size_t> labelSets;
+		// by label set id + 1, 0 for the states that are not terminate
+		std::vector<size_t> blockOf(1, SIZE_MAX);
+		size_t blocks = 0;
+		keys.clear();
+		for (State s = 0; s != dfa.size(); ++s)
+		{
+			size_t key = 0;
+			if (dfa.isTerminate(s))
+			{
+				auto interned = labelSets.intern(dfa.getLabels(s));
+				if (interned.second)
 				{
-					minimized.setStart(i);
+					blockOf.push_back(SIZE_MAX);
 				}
+				key = interned.first + 1;
+			}
+			if (blockOf[key] == SIZE_MAX)
+			{
+				blockOf[key] = blocks++;
+			}
+			keys.push_back(blockOf[key]);
+		}
+		return blocks;
+	}
+
+	// the DFA of the blocks, with the edges of one state of each
+	static Automata Quotient(const Automata& dfa, const RefinablePartition& blocks)
+	{
+		Automata minimized;
+		for (size_t b = 0; b != blocks.size(); ++b)
+		{
+			minimized.generateState();
+		}
+		for (State s = 0; s != dfa.size(); ++s)
+		{
+			if (dfa.isTerminate(s))
+			{
+				SetTerminate(minimized, blocks.find(s), dfa.getLabels(s));
+			}
+			if (dfa.isStart(s))
+			{
+				minimized.setStart(blocks.find(s));
 			}
 		}
-		for (State i = 0; i != groups.size(); ++i)
+		for (size_t b = 0; b != blocks.size(); ++b)
 		{
-			auto edges = dfa.getNeighbours(groups[i].last());
-			for (auto j = edges.begin(); j != edges.end(); ++j)
+			auto& edges = dfa.getNeighbours(*blocks.begin(b));
+			for (auto e = edges.begin(); e != edges.end(); ++e)
 			{
-				minimized.addTransition(i, groupMap[j->getTo()], j->getTransition());
+				minimized.addTransition(b, blocks.find(e->getTo()), e->getTransition());
 			}
 		}
 		return minimized;
 	}
+
+	static void SetTerminate(Automata& automata, State s, const SortedVectorSet<size_t>& labels)
+	{
+		automata.setTerminate(s);
+		for (auto i = labels.begin(); i != labels.end(); ++i)
+		{
+			automata.setTerminate(s, *i);
+		}
+	}
+
+	static Transition ClassTransition(const RangeSet& st)
+	{
+		if (st.begin() + 1 == st.end() && st.begin()->lower == st.begin()->upper)
+		{
+			return Transition(st.begin()->lower);
+		}
+		return Transition(st);
+	}
 };
 
 #endif
\ No newline at end of file
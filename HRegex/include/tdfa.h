@@ -0,0 +1,452 @@
+#ifndef _HREG_TDFA_
+#define _HREG_TDFA_
+
+#include "parser.h"
+#include "utf8ranges.h"
+#include "alphabet.h"
+#include "simplifier.h"
+
+/*
+
+	Tagged DFA
+
+	A DFA that extracts captures (Laurikari's TDFA), for patterns that
+	are not one-pass. The subset construction is the leftmost-first one :
+	a DFA state is the list of NFA threads in priority order, but every
+	thread also owns one register per capture slot. Thread i of a state
+	keeps slot t in register 1 + i * T + t (T slots per thread), so the
+	registers are implied by the thread list and a state needs nothing
+	else to be identified.
+
+	A transition carries the register operations that turn the threads
+	of its source into the threads of its target : a copy when a thread
+	moves to another position in the list, a write of the current offset
+	when its epsilon path crosses a tagged edge. Copies are ordered so
+	none overwrites a register still to be read, a cycle goes through
+	the spare register 0. An accepting state has a final fixup : the
+	thread whose registers hold the captures of the match.
+
+	The DFA is then minimized with Simplifier::Minimize, each
+	(symbol class, operations) pair being a symbol of its own and each
+	fixup a label, so only states with the same operations ahead are
+	merged.
+
+	Only full matches are supported (the whole input must match), with
+	at most 31 capture groups.
+
+	! NOTE : the registers are reused by every match, a TaggedDFA must
+	         not be shared between threads
+
+*/
+
+class TaggedDFA
+{
+public:
+	enum : size_t { NONE = SIZE_MAX };
+
+	static const size_t DEFAULT_STATE_LIMIT = 10000;
+
+	// throw TooManyStatesError when more than maxStates states are needed,
+	// the dead state included
+	// throw IllegalStateError for more than 31 capture groups
+	TaggedDFA(const char* pattern, size_t maxStates = DEFAULT_STATE_LIMIT)
+	{
+		Automata codepoints;
+		Parser<UTF8> parser(pattern, codepoints);
+		nfa = UTF8Ranges::CompileToBytes(codepoints);
+		classes = SymbolClasses(nfa);
+		slotCount = 2 * (parser.getCaptureCount() + 1);
+		if (slotCount > 64)
+		{
+			throw IllegalStateError();
+		}
+		tagCount = slotCount - 2;
+		important.resize(nfa.size(), false);
+		for (State s = 0; s != nfa.size(); ++s)
+		{
+			auto& edges = nfa.getNeighbours(s);
+			important[s] = nfa.isTerminate(s) ||
+				std::find_if(edges.begin(), edges.end(), [](const Edge& e)
+			{
+				return e.getTransition().getType() != Transition::EPSILON;
+			}) != edges.end();
+		}
+		minimize(determinize(maxStates));
+	}
+
+	// number of groups, including group 0
+	size_t getGroupCount() const
+	{
+		return slotCount / 2;
+	}
+
+	// number of DFA states, including the dead state
+	size_t size() const
+	{
+		return fixups.size();
+	}
+
+	// number of registers, including the spare one
+	size_t getRegisterCount() const
+	{
+		return registers.size();
+	}
+
+	// whether the whole text matches, captures like PikeVM::match
+	bool match(const char* text, size_t length, std::vector<size_t>& captures)
+	{
+		if (startRow == DEAD)
+		{
+			return false;
+		}
+		const HRegexByte* str = reinterpret_cast<const HRegexByte*>(text);
+		std::fill(registers.begin(), registers.end(), NONE);
+		execute(startOperations, 0);
+		uint32_t current = startRow;
+		for (size_t i = 0; i < length; ++i)
+		{
+			const Entry& e = table[current * classes.size() + classes.classOf(str[i])];
+			if (e.next == DEAD)
+			{
+				return false;
+			}
+			execute(e.operations, i + 1);
+			current = e.next;
+		}
+		if (fixups[current] == NO_FIXUP)
+		{
+			return false;
+		}
+		captures.assign(slotCount, NONE);
+		captures[0] = 0;
+		captures[1] = length;
+		auto first = registers.begin() + 1 + fixups[current] * tagCount;
+		std::copy(first, first + tagCount, captures.begin() + 2);
+		return true;
+	}
+
+private:
+	enum : uint32_t { DEAD = 0, NO_FIXUP = UINT32_MAX, POSITION = UINT32_MAX };
+
+	// registers[to] = src == POSITION ? current offset : registers[from]
+	struct Operation
+	{
+		uint32_t to;
+		uint32_t from;
+
+		bool operator<(const Operation& other) const
+		{
+			return to != other.to ? to < other.to : from < other.from;
+		}
+	};
+
+	struct Entry
+	{
+		uint32_t next;
+		uint32_t operations;
+	};
+
+	// a thread of a state under construction
+	struct Thread
+	{
+		State state;
+		uint32_t parent;
+		uint64_t tags;
+	};
+
+	void execute(uint32_t operations, size_t position)
+	{
+		auto& ops = operationLists[operations];
+		for (auto op = ops.begin(); op != ops.end(); ++op)
+		{
+			registers[op->to] = op->from == POSITION ? position : registers[op->from];
+		}
+	}
+
+	// leftmost-first epsilon closure, seeds in priority order
+	std::vector<Thread> closure(const std::vector<Thread>& seeds) const
+	{
+		std::vector<Thread> threads;
+		std::vector<bool> mark(nfa.size(), false);
+		std::vector<Thread> stk;
+		for (auto seed = seeds.begin(); seed != seeds.end(); ++seed)
+		{
+			stk.push_back(*seed);
+			while (!stk.empty())
+			{
+				Thread t = stk.back();
+				stk.pop_back();
+				if (mark[t.state])
+				{
+					continue;
+				}
+				mark[t.state] = true;
+				if (important[t.state])
+				{
+					threads.push_back(t);
+				}
+				auto& edges = nfa.getNeighbours(t.state);
+				for (auto e = edges.rbegin(); e != edges.rend(); ++e)
+				{
+					const Transition& tr = e->getTransition();
+					if (tr.getType() != Transition::EPSILON)
+					{
+						continue;
+					}
+					Thread next = { e->getTo(), t.parent, t.tags };
+					if (tr.getTag() >= 2)
+					{
+						next.tags |= static_cast<uint64_t>(1) << tr.getTag();
+					}
+					stk.push_back(next);
+				}
+			}
+		}
+		return threads;
+	}
+
+	// operations moving the registers of the parents to the threads
+	std::vector<Operation> operationsOf(const std::vector<Thread>& threads) const
+	{
+		std::vector<Operation> copies;
+		std::vector<Operation> result;
+		for (uint32_t i = 0; i != threads.size(); ++i)
+		{
+			for (uint32_t t = 0; t != tagCount; ++t)
+			{
+				uint32_t to = static_cast<uint32_t>(1 + i * tagCount + t);
+				if (threads[i].tags & (static_cast<uint64_t>(1) << (t + 2)))
+				{
+					result.push_back({ to, POSITION });
+				}
+				else if (threads[i].parent != i && threads[i].parent != POSITION)
+				{
+					copies.push_back({ to, static_cast<uint32_t>(1 + threads[i].parent * tagCount + t) });
+				}
+			}
+		}
+		// writes go last, they read nothing
+		std::vector<Operation> writes;
+		writes.swap(result);
+		const uint32_t spare = 0;
+		while (!copies.empty())
+		{
+			// a copy whose target no other copy reads
+			auto ready = std::find_if(copies.begin(), copies.end(), [&](const Operation& op)
+			{
+				return std::find_if(copies.begin(), copies.end(), [&](const Operation& other)
+				{
+					return other.from == op.to;
+				}) == copies.end();
+			});
+			if (ready == copies.end())
+			{
+				// only cycles are left, save one target to the spare
+				uint32_t saved = copies.front().to;
+				result.push_back({ spare, saved });
+				for (auto op = copies.begin(); op != copies.end(); ++op)
+				{
+					if (op->from == saved)
+					{
+						op->from = spare;
+					}
+				}
+				continue;
+			}
+			result.push_back(*ready);
+			copies.erase(ready);
+		}
+		result.insert(result.end(), writes.begin(), writes.end());
+		return result;
+	}
+
+	uint32_t internOperations(const std::vector<Operation>& ops)
+	{
+		auto found = operationIds.find(ops);
+		if (found != operationIds.end())
+		{
+			return found->second;
+		}
+		uint32_t id = static_cast<uint32_t>(operationLists.size());
+		operationIds[ops] = id;
+		operationLists.push_back(ops);
+		return id;
+	}
+
+	// tagged subset construction, the raw table is encoded as an
+	// Automata for minimization : symbol cls * operation count + operations
+	Automata determinize(size_t maxStates)
+	{
+		std::map<std::vector<State>, uint32_t> stateIds;
+		std::vector<std::vector<Thread>> states;
+		std::vector<Entry> raw;
+		std::vector<uint32_t> rawFixups;
+		size_t maxThreads = 1;
+		auto intern = [&](const std::vector<Thread>& threads) -> uint32_t
+		{
+			if (threads.empty())
+			{
+				return DEAD;
+			}
+			std::vector<State> key;
+			for (auto t = threads.begin(); t != threads.end(); ++t)
+			{
+				key.push_back(t->state);
+			}
+			auto found = stateIds.find(key);
+			if (found != stateIds.end())
+			{
+				return found->second;
+			}
+			if (states.size() >= maxStates)
+			{
+				throw TooManyStatesError();
+			}
+			uint32_t id = static_cast<uint32_t>(states.size());
+			stateIds[key] = id;
+			states.push_back(threads);
+			raw.resize(raw.size() + classes.size(), Entry{ DEAD, 0 });
+			rawFixups.push_back(NO_FIXUP);
+			for (uint32_t i = 0; i != threads.size(); ++i)
+			{
+				if (nfa.isTerminate(threads[i].state))
+				{
+					rawFixups.back() = i;
+					break;
+				}
+			}
+			maxThreads = std::max(maxThreads, threads.size());
+			return id;
+		};
+
+		// the dead state, then the start state
+		states.push_back(std::vector<Thread>());
+		raw.resize(classes.size(), Entry{ DEAD, 0 });
+		rawFixups.push_back(NO_FIXUP);
+		operationLists.push_back(std::vector<Operation>());
+		operationIds[std::vector<Operation>()] = 0;
+		std::vector<Thread> startThreads;
+		if (nfa.size() != 0)
+		{
+			std::vector<Thread> seeds(1, Thread{ nfa.getStart().last(), POSITION, 0 });
+			startThreads = closure(seeds);
+		}
+		startRow = intern(startThreads);
+
+		for (uint32_t row = 1; row < states.size(); ++row)
+		{
+			for (size_t cls = 0; cls != classes.size(); ++cls)
+			{
+				UnicodeChar ch = classes.representative(cls);
+				std::vector<Thread> seeds;
+				auto& threads = states[row];
+				for (uint32_t i = 0; i != threads.size(); ++i)
+				{
+					auto& edges = nfa.getNeighbours(threads[i].state);
+					for (auto e = edges.begin(); e != edges.end(); ++e)
+					{
+						const Transition& t = e->getTransition();
+						if (t.getType() != Transition::EPSILON && t.check(ch))
+						{
+							seeds.push_back(Thread{ e->getTo(), i, 0 });
+						}
+					}
+				}
+				auto targetThreads = closure(seeds);
+				uint32_t target = intern(targetThreads);
+				raw[row * classes.size() + cls].next = target;
+				raw[row * classes.size() + cls].operations =
+					target == DEAD ? 0 : internOperations(operationsOf(targetThreads));
+			}
+		}
+		registers.resize(maxThreads * tagCount + 1);
+		startOperations = internOperations(operationsOf(startThreads));
+
+		Automata result;
+		for (size_t i = 0; i != states.size(); ++i)
+		{
+			result.generateState();
+		}
+		// every symbol cls * operation count + operations must fit
+		if (classes.size() > UINT32_MAX / operationLists.size())
+		{
+			throw TooManyStatesError();
+		}
+		UnicodeChar opsCount = static_cast<UnicodeChar>(operationLists.size());
+		for (State s = 0; s != states.size(); ++s)
+		{
+			for (size_t cls = 0; cls != classes.size(); ++cls)
+			{
+				const Entry& e = raw[s * classes.size() + cls];
+				if (e.next != DEAD)
+				{
+					result.addTransition(s, e.next,
+						Transition(static_cast<UnicodeChar>(cls) * opsCount + e.operations));
+				}
+			}
+			if (rawFixups[s] != NO_FIXUP)
+			{
+				result.setTerminate(s);
+				result.setTerminate(s, rawFixups[s]);
+			}
+		}
+		result.setStart(startRow == DEAD ? 0 : startRow);
+		return result;
+	}
+
+	// minimize and decode back to a table, the dead state is row 0
+	void minimize(const Automata& determinized)
+	{
+		UnicodeChar opsCount = static_cast<UnicodeChar>(operationLists.size());
+		Automata minimized = Simplifier::Minimize(determinized);
+		State start = minimized.getStart().last();
+		// the minimized state holding the dead state has no edge and no
+		// fixup, it is mapped to row 0 along with any equivalent one
+		std::vector<uint32_t> rows(minimized.size(), DEAD);
+		uint32_t count = 1;
+		for (State s = 0; s != minimized.size(); ++s)
+		{
+			if (!minimized.getNeighbours(s).empty() || minimized.isTerminate(s))
+			{
+				rows[s] = count++;
+			}
+		}
+		table.assign(count * classes.size(), Entry{ DEAD, 0 });
+		fixups.assign(count, NO_FIXUP);
+		for (State s = 0; s != minimized.size(); ++s)
+		{
+			if (rows[s] == DEAD)
+			{
+				continue;
+			}
+			auto& edges = minimized.getNeighbours(s);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				UnicodeChar symbol = e->getTransition().getMatch();
+				Entry& entry = table[rows[s] * classes.size() + symbol / opsCount];
+				entry.next = rows[e->getTo()];
+				entry.operations = symbol % opsCount;
+			}
+			if (minimized.isTerminate(s))
+			{
+				fixups[rows[s]] = static_cast<uint32_t>(*minimized.getLabels(s).begin());
+			}
+		}
+		startRow = startRow == DEAD ? DEAD : rows[start];
+	}
+
+	Automata nfa;
+	SymbolClasses classes;
+	size_t slotCount;
+	size_t tagCount;
+	std::vector<bool> important;
+	std::map<std::vector<Operation>, uint32_t> operationIds;
+	std::vector<std::vector<Operation>> operationLists;
+	uint32_t startOperations;
+	uint32_t startRow;
+	std::vector<Entry> table;
+	std::vector<uint32_t> fixups;
+	std::vector<size_t> registers;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,265 @@
+#ifndef _HREG_UTF8RANGES_
+#define _HREG_UTF8RANGES_
+
+#include "automata.h"
+
+/*
+
+	Compile a codepoint automata to a byte automata
+
+	Every codepoint interval is split into sequences of byte ranges that
+	together match exactly the UTF-8 encodings of the interval, e.g.
+
+		[0x0, 0x10FFFF] =
+			[00-7F]
+			[C2-DF][80-BF]
+			[E0][A0-BF][80-BF]
+			[E1-EC][80-BF][80-BF]
+			[ED][80-9F][80-BF]
+			[EE-EF][80-BF][80-BF]
+			[F0][90-BF][80-BF][80-BF]
+			[F1-F3][80-BF][80-BF][80-BF]
+			[F4][80-8F][80-BF][80-BF]
+
+	Surrogates and values above 0x10FFFF have no encoding and are dropped,
+	so malformed input simply has no transition (dead state) instead of
+	being decoded. The result should be matched with StreamReader<RAW>,
+	lengths and offsets are then in bytes.
+
+*/
+
+struct UTF8Sequence
+{
+	size_t length;
+	Range bytes[4];
+};
+
+class UTF8Ranges
+{
+public:
+	static const UnicodeChar MAX_CODEPOINT = 0x10ffff;
+
+	// split [lower, upper] into byte range sequences (ascending order)
+	static std::vector<UTF8Sequence> Sequences(UnicodeChar lower, UnicodeChar upper)
+	{
+		std::vector<UTF8Sequence> result;
+		std::stack<Range> stk;
+		stk.push({ lower, upper });
+		while (!stk.empty())
+		{
+			UnicodeChar s = stk.top().lower;
+			UnicodeChar e = stk.top().upper;
+			stk.pop();
+			if (e > MAX_CODEPOINT)
+			{
+				e = MAX_CODEPOINT;
+			}
+			if (s > e)
+			{
+				continue;
+			}
+			// surrogates are not encodable
+			if (s <= 0xdfff && e >= 0xd800)
+			{
+				if (e > 0xdfff)
+				{
+					stk.push({ 0xe000, e });
+				}
+				if (s < 0xd800)
+				{
+					stk.push({ s, 0xd7ff });
+				}
+				continue;
+			}
+			if (splitAt(stk, s, e, 0x7f) ||
+				splitAt(stk, s, e, 0x7ff) ||
+				splitAt(stk, s, e, 0xffff))
+			{
+				continue;
+			}
+			// now s and e encode to the same length, make every
+			// continuation byte (except the first differing one) span
+			// the whole [80-BF] range
+			bool split = false;
+			for (int i = 1; i < 4 && !split; ++i)
+			{
+				UnicodeChar m = (1u << (6 * i)) - 1;
+				if ((s & ~m) != (e & ~m))
+				{
+					if ((s & m) != 0)
+					{
+						stk.push({ (s | m) + 1, e });
+						stk.push({ s, s | m });
+						split = true;
+					}
+					else if ((e & m) != m)
+					{
+						stk.push({ e & ~m, e });
+						stk.push({ s, (e & ~m) - 1 });
+						split = true;
+					}
+				}
+			}
+			if (split)
+			{
+				continue;
+			}
+			HRegexByte first[4];
+			HRegexByte last[4];
+			UTF8Sequence seq;
+			seq.length = Encode(s, first);
+			Encode(e, last);
+			for (size_t i = 0; i != seq.length; ++i)
+			{
+				seq.bytes[i].lower = first[i];
+				seq.bytes[i].upper = last[i];
+			}
+			result.push_back(seq);
+		}
+		return result;
+	}
+
+	// encode a single codepoint, return the number of bytes written
+	static size_t Encode(UnicodeChar ch, HRegexByte* out)
+	{
+		if (ch < 0x80)
+		{
+			out[0] = static_cast<HRegexByte>(ch);
+			return 1;
+		}
+		else if (ch < 0x800)
+		{
+			out[0] = static_cast<HRegexByte>(0xc0 | (ch >> 6));
+			out[1] = static_cast<HRegexByte>(0x80 | (ch & 0x3f));
+			return 2;
+		}
+		else if (ch < 0x10000)
+		{
+			out[0] = static_cast<HRegexByte>(0xe0 | (ch >> 12));
+			out[1] = static_cast<HRegexByte>(0x80 | ((ch >> 6) & 0x3f));
+			out[2] = static_cast<HRegexByte>(0x80 | (ch & 0x3f));
+			return 3;
+		}
+		else
+		{
+			out[0] = static_cast<HRegexByte>(0xf0 | (ch >> 18));
+			out[1] = static_cast<HRegexByte>(0x80 | ((ch >> 12) & 0x3f));
+			out[2] = static_cast<HRegexByte>(0x80 | ((ch >> 6) & 0x3f));
+			out[3] = static_cast<HRegexByte>(0x80 | (ch & 0x3f));
+			return 4;
+		}
+	}
+
+	// rewrite every transition into chains of byte transitions
+	// states of the input keep their numbers, new states are appended
+	// ! NOTE : the result is an NFA, determinize it again if needed
+	static Automata CompileToBytes(const Automata& automata)
+	{
+		Automata bytes;
+		for (size_t i = 0; i != automata.size(); ++i)
+		{
+			bytes.generateState();
+		}
+		for (auto i = automata.getStart().begin(); i != automata.getStart().end(); ++i)
+		{
+			bytes.setStart(*i);
+		}
+		for (auto i = automata.getTerminate().begin(); i != automata.getTerminate().end(); ++i)
+		{
+			bytes.setTerminate(*i);
+			auto labels = automata.getLabels(*i);
+			for (auto j = labels.begin(); j != labels.end(); ++j)
+			{
+				bytes.setTerminate(*i, *j);
+			}
+		}
+		for (State s = 0; s != automata.size(); ++s)
+		{
+			auto& edges = automata.getNeighbours(s);
+			for (auto e = edges.begin(); e != edges.end(); ++e)
+			{
+				Transition t = e->getTransition();
+				std::vector<UTF8Sequence> sequences;
+				switch (t.getType())
+				{
+				case Transition::EPSILON:
+					bytes.addTransition(s, e->getTo(), t);
+					continue;
+				case Transition::NORMAL:
+					sequences = Sequences(t.getMatch(), t.getMatch());
+					break;
+				case Transition::WILDCARD:
+					sequences = Sequences(0, MAX_CODEPOINT);
+					break;
+				case Transition::RANGE:
+					for (auto r = t.getRangeSet().begin(); r != t.getRangeSet().end(); ++r)
+					{
+						auto part = Sequences(r->lower, r->upper);
+						sequences.insert(sequences.end(), part.begin(), part.end());
+					}
+					break;
+				}
+				addSequences(bytes, s, e->getTo(), sequences);
+			}
+		}
+		return bytes;
+	}
+
+private:
+	static bool splitAt(std::stack<Range>& stk, UnicodeChar s, UnicodeChar e, UnicodeChar max)
+	{
+		if (s <= max && max < e)
+		{
+			stk.push({ max + 1, e });
+			stk.push({ s, max });
+			return true;
+		}
+		return false;
+	}
+
+	static Transition byteTransition(const Range& r)
+	{
+		if (r.lower == r.upper)
+		{
+			return Transition(r.lower);
+		}
+		RangeSet st;
+		st.insert(r);
+		return Transition(st);
+	}
+
+	// build a prefix tree of the sequences between from and to
+	static void addSequences(Automata& bytes, State from, State to,
+		const std::vector<UTF8Sequence>& sequences)
+	{
+		// (parent, byte range) -> child, only for inner nodes
+		std::vector<std::pair<std::pair<State, Range>, State>> children;
+		for (auto seq = sequences.begin(); seq != sequences.end(); ++seq)
+		{
+			State current = from;
+			for (size_t i = 0; i + 1 < seq->length; ++i)
+			{
+				const Range& r = seq->bytes[i];
+				auto found = std::find_if(children.begin(), children.end(),
+					[&](const std::pair<std::pair<State, Range>, State>& c)
+				{
+					return c.first.first == current && c.first.second == r;
+				});
+				if (found != children.end())
+				{
+					current = found->second;
+				}
+				else
+				{
+					State next = bytes.generateState();
+					bytes.addTransition(current, next, byteTransition(r));
+					children.push_back({ { current, r }, next });
+					current = next;
+				}
+			}
+			bytes.addTransition(current, to, byteTransition(seq->bytes[seq->length - 1]));
+		}
+	}
+};
+
+#endif
\ No newline at end of file
@@ -3,6 +3,19 @@
 #include "testContainers.h"
 #include "testSimplifier.h"
 #include "testEncoding.h"
+#include "testDenseDFA.h"
+#include "testUTF8Ranges.h"
+#include "testAlphabet.h"
+#include "testLazyDFA.h"
+#include "testSearch.h"
+#include "testPrefilter.h"
+#include "testRegexSet.h"
+#include "testLexer.h"
+#include "testPikeVM.h"
+#include "testOnePass.h"
+#include "testTDFA.h"
+#include "testBacktrack.h"
+#include "testBitNFA.h"
 
 int main()
 {
@@ -11,6 +24,19 @@ int main()
 	automataSuit();
 	parserSuit();
 	simplifierSuit();
+	denseDFASuit();
+	utf8RangesSuit();
+	alphabetSuit();
+	lazyDFASuit();
+	searchSuit();
+	prefilterSuit();
+	regexSetSuit();
+	lexerSuit();
+	pikeVMSuit();
+	onePassSuit();
+	taggedDFASuit();
+	backtrackSuit();
+	bitNFASuit();
 
 	//Automata a;
 	//Parser<ASCII>("ss(s(ss?)?)?", a);
@@ -0,0 +1,82 @@
+/************************************************************************/
+/*  Test Symbol Classes
+/************************************************************************/
+
+#include "parser.h"
+#include "alphabet.h"
+#include "utf8ranges.h"
+#include "cute/cute.h"
+
+void testSingleClass()
+{
+	SymbolClasses classes;
+	ASSERT_EQUAL(1, classes.size());
+	ASSERT_EQUAL(0, classes.classOf('a'));
+	ASSERT_EQUAL(0, classes.classOf(0x10ffff));
+
+	Automata nfa;
+	Parser<ASCII>("a*", nfa);
+	SymbolClasses single(nfa);
+	ASSERT_EQUAL(2, single.size());
+	ASSERT(single.classOf('a') != single.classOf('b'));
+	ASSERT_EQUAL(single.classOf('b'), single.classOf(0));
+	ASSERT_EQUAL('a', single.representative(single.classOf('a')));
+}
+
+void testCoarsestPartition()
+{
+	// [a-c] and [x-z] always appear together, so they form one class
+	RangeSet st;
+	st.insert({ 'a', 'c' });
+	st.insert({ 'x', 'z' });
+	Automata nfa;
+	nfa.generateState();
+	nfa.generateState();
+	nfa.addTransition(0, 1, st);
+	nfa.addTransition(0, 1, static_cast<HRegexByte>('b'));
+	nfa.addTransition(1, 0, Transition::WILDCARD);
+	nfa.addTransition(1, 0, Transition::EPSILON);
+	SymbolClasses classes(nfa);
+	// 'b', [ac] + [x-z], everything else
+	ASSERT_EQUAL(3, classes.size());
+	ASSERT_EQUAL(classes.classOf('a'), classes.classOf('z'));
+	ASSERT_EQUAL(classes.classOf('c'), classes.classOf('x'));
+	ASSERT(classes.classOf('a') != classes.classOf('b'));
+	ASSERT_EQUAL(classes.classOf('d'), classes.classOf(0));
+	ASSERT_EQUAL(classes.classOf('d'), classes.classOf(0x4e07));
+	ASSERT(classes.classOf('d') != classes.classOf('a'));
+
+	auto covered = classes.classesOf(Transition(st));
+	ASSERT_EQUAL(2, covered.size());
+	ASSERT_EQUAL(classes.size(), classes.classesOf(Transition::WILDCARD).size());
+	ASSERT_EQUAL(0, classes.classesOf(Transition::EPSILON).size());
+
+	RangeSet rest = classes.getRangeSet(classes.classOf('a'));
+	ASSERT(rest.contains('a'));
+	ASSERT(rest.contains('c'));
+	ASSERT(rest.contains('y'));
+	ASSERT(!rest.contains('b'));
+	ASSERT(!rest.contains('d'));
+}
+
+void testByteClasses()
+{
+	Automata nfa;
+	Parser<UTF8>("(\\d|\xe5\x85\xab)+", nfa);
+	nfa = UTF8Ranges::CompileToBytes(nfa);
+	SymbolClasses classes(nfa);
+	// digits, E5, 85, AB, everything else
+	ASSERT_EQUAL(5, classes.size());
+	ASSERT_EQUAL(classes.classOf(0xff), classes.classOf(0x110000));
+}
+
+// Test suits
+
+void alphabetSuit()
+{
+	cute::suite s;
+	s += CUTE(testSingleClass);
+	s += CUTE(testCoarsestPartition);
+	s += CUTE(testByteClasses);
+	cute::runner<cute::ostream_listener>()(s, "Symbol Classes Test");
+}
\ No newline at end of file
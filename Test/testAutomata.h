@@ -5,6 +5,8 @@
 // TODO : test input move
 
 #include "automata.h"
+#include "nfasim.h"
+#include "parser.h"
 #include "cute/cute.h"
 
 void testTransitionEqualAndType()
@@ -147,6 +149,35 @@ void testGetNoneEpsilonTransitions()
 	ASSERT_EQUAL(2, result.size());
 }
 
+void testGetAtoms()
+{
+	Automata nfa;
+	State s1 = nfa.generateState();
+	State s2 = nfa.generateState();
+	RangeSet letters;
+	letters.insert({ 'a', 'z' });
+	nfa.addTransition(s1, s2, letters);
+	nfa.addTransition(s1, s2, static_cast<HRegexByte>('k'));
+	nfa.addTransition(s1, s2, static_cast<HRegexByte>('0'));
+	nfa.addTransition(s1, s2, Transition::EPSILON);
+
+	SortedVectorSet<State> states;
+	states.insert(s1);
+	auto atoms = nfa.getAtoms(states);
+	ASSERT_EQUAL(4, atoms.size());
+	ASSERT(atoms[0] == Range({ '0', '0' }));
+	ASSERT(atoms[1] == Range({ 'a', 'j' }));
+	ASSERT(atoms[2] == Range({ 'k', 'k' }));
+	ASSERT(atoms[3] == Range({ 'l', 'z' }));
+
+	// the wildcard covers everything, up to the last code unit
+	nfa.addTransition(s1, s2, Transition::WILDCARD);
+	atoms = nfa.getAtoms(states);
+	ASSERT_EQUAL(7, atoms.size());
+	ASSERT_EQUAL(0, atoms.front().lower);
+	ASSERT_EQUAL(UINT32_MAX, atoms.back().upper);
+}
+
 void testEpsilonClosure()
 {
 	Automata nfa;
@@ -175,6 +206,56 @@ void testEpsilonClosure()
 	ASSERT(!states.contains(s6));
 }
 
+void testEpsilonClosures()
+{
+	Automata nfa;
+	for (int i = 0; i != 6; ++i)
+	{
+		nfa.generateState();
+	}
+	nfa.addTransition(0, 1, Transition::EPSILON);
+	nfa.addTransition(1, 0, Transition::EPSILON);
+	nfa.addTransition(0, 2, Transition::EPSILON);
+	nfa.addTransition(1, 3, Transition::EPSILON);
+	nfa.addTransition(0, 4, static_cast<HRegexByte>('K'));
+	nfa.addTransition(4, 5, Transition::EPSILON);
+	EpsilonClosures closures(nfa);
+	// {0, 1, 2, 3} twice, {2}, {3}, {4, 5}, {5}
+	ASSERT_EQUAL(13, closures.getClosureSize());
+	ASSERT_EQUAL(4, closures.closure(1).size());
+	ASSERT(!closures.closure(1).contains(4));
+	SortedVectorSet<State> states;
+	states.insert(2);
+	states.insert(4);
+	auto merged = closures.closure(states);
+	ASSERT_EQUAL(3, merged.size());
+	ASSERT_EQUAL(2, *merged.begin());
+	ASSERT_EQUAL(5, merged.last());
+	// only 0, which consumes, and 5, which accepts
+	nfa.setTerminate(5);
+	EpsilonClosures important(nfa, EpsilonClosures::IMPORTANT_STATES);
+	// {0} twice, {}, {}, {5}, {5}
+	ASSERT_EQUAL(4, important.getClosureSize());
+	ASSERT_EQUAL(0, *important.begin(1));
+	ASSERT_EQUAL(1, important.end(1) - important.begin(1));
+	ASSERT(important.begin(2) == important.end(2));
+
+	// every subset of a Thompson automata, against a search
+	Automata thompson;
+	Parser<ASCII>("(a|b*)*c?(d|e)?", thompson);
+	EpsilonClosures table(thompson);
+	for (State from = 0; from != thompson.size(); ++from)
+	{
+		for (State to = from; to < thompson.size(); to += 3)
+		{
+			SortedVectorSet<State> subset;
+			subset.insert(from);
+			subset.insert(to);
+			ASSERT(thompson.epsilonClosure(subset) == table.closure(subset));
+		}
+	}
+}
+
 void testMove()
 {
 	Automata nfa;
@@ -266,6 +347,36 @@ void testSimulate()
 	ASSERT(!nfa.simulate<ASCII>("b", 1));
 }
 
+void testNFASimulator()
+{
+	const char* patterns[] = { "(ab|a)*\\dc?", "a{2,3}b{2,}", "(a*)*", "a?|b{0,2}", "(.b)+|c" };
+	const char* texts[] = { "", "a", "b", "ab", "aab", "aaab", "abbb", "1", "ab1c", "aaba9",
+		"aaaabbb", "bb", "bbb", "cb", "xbab", "c" };
+	for (auto p : patterns)
+	{
+		Automata nfa;
+		Parser<ASCII>(p, nfa);
+		NFASimulator simulator(nfa);
+		ASSERT(simulator.getClosureSize() < nfa.size() * nfa.size());
+		for (auto t : texts)
+		{
+			// subset by subset, as a reference
+			SortedVectorSet<State> states = nfa.getStart();
+			for (const char* c = t; *c != 0; ++c)
+			{
+				states = nfa.move(nfa.epsilonClosure(states), static_cast<UnicodeChar>(*c));
+			}
+			bool expected = nfa.containsTerminate(nfa.epsilonClosure(states));
+			size_t len = std::char_traits<char>::length(t);
+			ASSERT_EQUAL(expected, nfa.simulate<ASCII>(t, len));
+			ASSERT_EQUAL(expected, simulator.simulate<ASCII>(t, len));
+		}
+	}
+	Automata empty;
+	NFASimulator emptySimulator(empty);
+	ASSERT(!emptySimulator.simulate<ASCII>("", 0));
+}
+
 // Test suits
 
 void automataSuit()
@@ -279,8 +390,11 @@ void automataSuit()
 	s += CUTE(testStartTerminate);
 	s += CUTE(testTerminateSet);
 	s += CUTE(testGetNoneEpsilonTransitions);
+	s += CUTE(testGetAtoms);
 	s += CUTE(testEpsilonClosure);
+	s += CUTE(testEpsilonClosures);
 	s += CUTE(testSimulate);
+	s += CUTE(testNFASimulator);
 	s += CUTE(testMove);
 	s += CUTE(testReverseEdges);
 	cute::runner<cute::ostream_listener>()(s, "Automata Test");
@@ -0,0 +1,85 @@
+/************************************************************************/
+/*  Test bounded backtracker and capture matcher
+/************************************************************************/
+
+#include "backtrack.h"
+#include "capture.h"
+#include "cute/cute.h"
+
+void testBacktrackCaptures()
+{
+	std::vector<size_t> caps;
+	BoundedBacktracker bt("(a|ab)(c|bcd)(d*)");
+	ASSERT_EQUAL(4, bt.getGroupCount());
+	ASSERT(bt.find("xabcd", 5, caps));
+	ASSERT_EQUAL(1, caps[0]);
+	ASSERT_EQUAL(5, caps[1]);
+	ASSERT_EQUAL(2, caps[3]);
+	ASSERT_EQUAL(5, caps[5]);
+	ASSERT(bt.match("abcdd", 5, caps));
+	ASSERT_EQUAL(1, caps[3]);
+	ASSERT_EQUAL(4, caps[5]);
+	ASSERT_EQUAL(5, caps[7]);
+	ASSERT(!bt.match("xabcd", 5, caps));
+
+	// the last iteration is kept, a group that did not take part is unset
+	BoundedBacktracker repeat("((a)|b)+");
+	ASSERT(repeat.find("abab", 4, caps));
+	ASSERT_EQUAL(3, caps[2]);
+	ASSERT_EQUAL(4, caps[3]);
+	ASSERT_EQUAL(2, caps[4]);
+	ASSERT_EQUAL(3, caps[5]);
+	BoundedBacktracker either("(a)|(b)");
+	ASSERT(either.find("cb", 2, caps));
+	ASSERT_EQUAL(BoundedBacktracker::NONE, caps[2]);
+	ASSERT_EQUAL(1, caps[4]);
+}
+
+void testBacktrackIsBounded()
+{
+	std::vector<size_t> caps;
+	// exponential without the visited bitset
+	BoundedBacktracker blowup("(a*)*b");
+	std::string text(blowup.getMaxLength(), 'a');
+	ASSERT(!blowup.find(text.c_str(), text.size(), caps));
+	text += 'a';
+	ASSERT_THROWS(blowup.find(text.c_str(), text.size(), caps), IllegalStateError);
+	// only the part after from counts
+	ASSERT(!blowup.find(text.c_str(), text.size(), caps, 1));
+}
+
+void testCaptureMatcherPicksEngine()
+{
+	std::vector<size_t> caps;
+	CaptureMatcher range("(\\d+)-(\\d+)");
+	ASSERT_EQUAL(CaptureMatcher::ONE_PASS, range.engineFor(6, true));
+	ASSERT_EQUAL(CaptureMatcher::BACKTRACK, range.engineFor(6, false));
+	ASSERT_EQUAL(CaptureMatcher::PIKE_VM, range.engineFor(1 << 20, false));
+	ASSERT(range.match("12-345", 6, caps));
+	ASSERT_EQUAL(2, caps[3]);
+	ASSERT_EQUAL(3, caps[4]);
+
+	CaptureMatcher field("(.*)=(\\d+)");
+	ASSERT_EQUAL(CaptureMatcher::BACKTRACK, field.engineFor(6, true));
+	ASSERT(field.match("a=b=42", 6, caps));
+	ASSERT_EQUAL(3, caps[3]);
+	// too long for the backtracker, same captures from the Pike VM
+	std::string text(1 << 16, 'x');
+	text += "=7";
+	ASSERT_EQUAL(CaptureMatcher::PIKE_VM, field.engineFor(text.size(), true));
+	ASSERT(field.match(text.c_str(), text.size(), caps));
+	ASSERT_EQUAL(text.size() - 2, caps[3]);
+	ASSERT(field.find(text.c_str(), text.size(), caps, 10));
+	ASSERT_EQUAL(10, caps[0]);
+}
+
+// Test suits
+
+void backtrackSuit()
+{
+	cute::suite s;
+	s += CUTE(testBacktrackCaptures);
+	s += CUTE(testBacktrackIsBounded);
+	s += CUTE(testCaptureMatcherPicksEngine);
+	cute::runner<cute::ostream_listener>()(s, "Backtrack Test");
+}
\ No newline at end of file
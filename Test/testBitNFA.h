@@ -0,0 +1,77 @@
+/************************************************************************/
+/*  Test bit-parallel NFA
+/************************************************************************/
+
+#include "bitnfa.h"
+#include "cute/cute.h"
+
+void testBitNFASingleWord()
+{
+	BitParallelNFA nfa("(ab|a)*\\dc?");
+	ASSERT(nfa.getPositionCount() <= 64);
+	ASSERT(nfa.match("aba1c", 5));
+	ASSERT(nfa.match("7", 1));
+	ASSERT(!nfa.match("ab", 2));
+	ASSERT(!nfa.match("aba1cc", 6));
+	ASSERT(nfa.isMatch("xx ab9 yy", 9));
+	ASSERT(!nfa.isMatch("xx ab yy", 8));
+
+	// U+767E, the wildcard is split into a position per UTF-8 range
+	BitParallelNFA utf8("x\xe7\x99\xbe+.");
+	ASSERT(utf8.match("x\xe7\x99\xbe\xe7\x99\xbe\xc3\xa9", 9));
+	ASSERT(!utf8.match("x\xe7\x99\xbe\xe7\x99", 6));
+	ASSERT(utf8.isMatch("ax\xe7\x99\xbe!", 6));
+
+	BitParallelNFA nullable("a*");
+	ASSERT(nullable.match("", 0));
+	ASSERT(nullable.isMatch("b", 1));
+}
+
+void testBitNFAMultiWord()
+{
+	// the DFA needs 2^80 states
+	BitParallelNFA nfa("(a|b)*a(a|b){80}");
+	ASSERT(nfa.getPositionCount() > 64);
+	std::string text(200, 'b');
+	text[200 - 81] = 'a';
+	ASSERT(nfa.match(text.c_str(), text.size()));
+	ASSERT(nfa.isMatch(text.c_str(), text.size()));
+	text[200 - 81] = 'b';
+	text[200 - 80] = 'a';
+	ASSERT(!nfa.match(text.c_str(), text.size()));
+	ASSERT(!nfa.isMatch(text.c_str(), text.size()));
+	text += "ab";
+	ASSERT(!nfa.match(text.c_str(), text.size()));
+	ASSERT(nfa.isMatch(text.c_str(), text.size()));
+
+	ASSERT_THROWS(BitParallelNFA("a{600}"), TooManyStatesError);
+}
+
+void testBitNFAAgreesWithSimulate()
+{
+	const char* patterns[] = { "(ab|a)*\\dc?", "a{2,3}b{2,}", "(a*)*", "a?|b{0,2}",
+		"(.b)+|c", "((a|b){3}c){20}" };
+	const char* texts[] = { "", "a", "b", "ab", "aab", "aaab", "abbb", "1", "ab1c", "aaba9",
+		"aaaabbb", "bb", "bbb", "cb", "xbab", "c", "abacab" };
+	for (auto p : patterns)
+	{
+		Automata thompson;
+		Parser<UTF8>(p, thompson);
+		BitParallelNFA nfa(p);
+		for (auto t : texts)
+		{
+			ASSERT_EQUAL(thompson.simulate<UTF8>(t, strlen(t)), nfa.match(t, strlen(t)));
+		}
+	}
+}
+
+// Test suits
+
+void bitNFASuit()
+{
+	cute::suite s;
+	s += CUTE(testBitNFASingleWord);
+	s += CUTE(testBitNFAMultiWord);
+	s += CUTE(testBitNFAAgreesWithSimulate);
+	cute::runner<cute::ostream_listener>()(s, "Bit-parallel NFA Test");
+}
\ No newline at end of file
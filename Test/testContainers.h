@@ -217,6 +217,261 @@ void testCoW()
 	ASSERT_EQUAL(2, s2.size());
 }
 
+void testSetInlineStorage()
+{
+	SortedVectorSet<int> s;
+	for (int i = 8; i != 0; --i)
+	{
+		s.insert(i);
+	}
+	ASSERT(s.isInline());
+	SortedVectorSet<int> copy = s;
+	ASSERT(copy.remove(4));
+	ASSERT_EQUAL(8, s.size());
+	// spills past INLINE_CAPACITY, the copies share the heap vector
+	s.insert(0);
+	ASSERT(!s.isInline());
+	ASSERT_EQUAL(9, s.size());
+	ASSERT_EQUAL(0, *s.begin());
+	ASSERT_EQUAL(8, s.last());
+	SortedVectorSet<int> shared = s;
+	ASSERT(shared == s);
+	shared.popBack();
+	ASSERT_EQUAL(9, s.size());
+	ASSERT(s.contains(8));
+	ASSERT(!shared.contains(8));
+	// set operations spill as needed
+	SortedVectorSet<int> odd;
+	for (int i = 11; i < 30; i += 2)
+	{
+		odd.insert(i);
+	}
+	auto all = copy || odd;
+	ASSERT_EQUAL(17, all.size());
+	ASSERT(!all.isInline());
+	ASSERT((all - odd) == copy);
+	ASSERT((all - odd).isInline());
+	s.clear();
+	ASSERT(s.isInline());
+	ASSERT(s.isEmpty());
+}
+
+void testSetHash()
+{
+	SortedVectorSet<int> s1;
+	ASSERT_EQUAL(0, s1.getHash());
+	s1.insert(3);
+	s1.insert(1);
+	s1.insert(7);
+	s1.insert(3);
+	std::vector<int> sorted = { 1, 3, 7 };
+	SortedVectorSet<int> s2(sorted.begin(), sorted.end());
+	ASSERT_EQUAL(s2.getHash(), s1.getHash());
+	SortedVectorSet<int> s3;
+	s3.insert(1);
+	ASSERT(s3.getHash() != s1.getHash());
+	// set operations
+	SortedVectorSet<int> s4;
+	s4.insert(7);
+	s4.insert(3);
+	ASSERT_EQUAL(s1.getHash(), (s3 || s4).getHash());
+	ASSERT_EQUAL(s4.getHash(), (s1 - s3).getHash());
+	ASSERT_EQUAL(s3.getHash(), (s1 && s3).getHash());
+	// copies share the hash until written
+	SortedVectorSet<int> copy = s1;
+	ASSERT(copy.remove(7));
+	copy.popBack();
+	ASSERT_EQUAL(s3.getHash(), copy.getHash());
+	copy.clear();
+	ASSERT_EQUAL(0, copy.getHash());
+	ASSERT_EQUAL(s2.getHash(), s1.getHash());
+}
+
+void testSetInterner()
+{
+	SetInterner<int> interner;
+	std::vector<SortedVectorSet<int>> sets;
+	for (int i = 0; i != 100; ++i)
+	{
+		SortedVectorSet<int> s;
+		for (int j = 0; j <= i % 7; ++j)
+		{
+			s.insert(i * 3 + j);
+		}
+		sets.push_back(s);
+		auto interned = interner.intern(s);
+		ASSERT_EQUAL(i, interned.first);
+		ASSERT(interned.second);
+	}
+	ASSERT_EQUAL(100, interner.size());
+	for (int i = 0; i != 100; ++i)
+	{
+		auto interned = interner.intern(sets[i]);
+		ASSERT_EQUAL(i, interned.first);
+		ASSERT(!interned.second);
+		ASSERT(interner.get(i) == sets[i]);
+	}
+	SortedVectorSet<int> absent;
+	absent.insert(-1);
+	ASSERT_EQUAL(SetInterner<int>::NONE, interner.find(absent));
+	ASSERT_EQUAL(42, interner.find(sets[42]));
+	// the empty set is a set
+	ASSERT_EQUAL(100, interner.intern(SortedVectorSet<int>()).first);
+	interner.clear();
+	ASSERT_EQUAL(0, interner.size());
+	ASSERT_EQUAL(SetInterner<int>::NONE, interner.find(sets[42]));
+
+	// ranges : a sorted one is the set, another order another sequence
+	interner.intern(sets[5]);
+	std::vector<int> elements(sets[5].begin(), sets[5].end());
+	ASSERT_EQUAL(0, interner.find(elements.begin(), elements.end()));
+	std::reverse(elements.begin(), elements.end());
+	ASSERT_EQUAL(SetInterner<int>::NONE, interner.find(elements.begin(), elements.end()));
+	ASSERT_EQUAL(1, interner.intern(elements.begin(), elements.end()).first);
+	ASSERT_EQUAL(elements.front(), *interner.begin(1));
+
+	// sets never move, larger than a block or not
+	const int* first = interner.begin(0);
+	std::vector<int> large(SetInterner<int>::BLOCK_ELEMENTS + 1);
+	for (int i = 0; i != 100; ++i)
+	{
+		large[0] = i;
+		interner.intern(large.begin(), large.end());
+		interner.intern(large.begin(), large.begin() + 3);
+	}
+	ASSERT_EQUAL(202, interner.size());
+	ASSERT_EQUAL(first, interner.begin(0));
+	ASSERT(interner.get(0) == sets[5]);
+	ASSERT_EQUAL(large.size(), interner.size(100));
+
+	// the footprint is what the blocks and tables hold, clear keeps it,
+	// release gives it back
+	SetInterner<int> small(16);
+	size_t empty = small.getMemoryUsage();
+	size_t growth = small.getMemoryGrowth(3);
+	ASSERT(growth >= 16 * sizeof(int));
+	small.intern(large.begin(), large.begin() + 3);
+	ASSERT(small.getMemoryUsage() - empty <= growth);
+	// 13 more elements fit in the block, 14 do not
+	ASSERT_EQUAL(small.getMemoryGrowth(0), small.getMemoryGrowth(13));
+	ASSERT_EQUAL(small.getMemoryGrowth(0) + 16 * sizeof(int), small.getMemoryGrowth(14));
+	size_t used = small.getMemoryUsage();
+	small.clear();
+	ASSERT_EQUAL(used, small.getMemoryUsage());
+	small.release();
+	ASSERT_EQUAL(empty, small.getMemoryUsage());
+}
+
+void testDenseBitSet()
+{
+	DenseBitSet s1;
+	ASSERT(s1.isEmpty());
+	ASSERT(s1.insert(3));
+	ASSERT(s1.insert(70));
+	ASSERT(!s1.insert(3));
+	ASSERT(s1.contains(70));
+	ASSERT(!s1.contains(1000));
+	ASSERT_EQUAL(2, s1.size());
+	ASSERT(s1.isInline());
+	// ascending, across words
+	int values[] = { 1, 3, 63, 64, 200 };
+	DenseBitSet s2(values, values + 5);
+	std::vector<size_t> elements(s2.begin(), s2.end());
+	ASSERT_EQUAL(5, elements.size());
+	ASSERT(std::equal(elements.begin(), elements.end(), values));
+
+	SortedVectorSet<size_t> sorted1(s1.begin(), s1.end());
+	SortedVectorSet<size_t> sorted2(s2.begin(), s2.end());
+	auto same = [](const DenseBitSet& dense, const SortedVectorSet<size_t>& sorted)
+	{
+		return dense.size() == sorted.size() && std::equal(sorted.begin(), sorted.end(), dense.begin());
+	};
+	ASSERT(same(s1 || s2, sorted1 || sorted2));
+	ASSERT(same(s1 && s2, sorted1 && sorted2));
+	ASSERT(same(s2 - s1, sorted2 - sorted1));
+	ASSERT(s1.intersects(s2));
+	ASSERT(!(s2 - s1).intersects(s1));
+	ASSERT_EQUAL(sorted1 < sorted2, s1 < s2);
+
+	// equal whatever the capacity, past the inline words
+	DenseBitSet large(1000);
+	ASSERT(!large.isInline());
+	ASSERT(large.isEmpty());
+	large.insert(70);
+	large.insert(3);
+	ASSERT(large == s1);
+	ASSERT_EQUAL(large.getHash(), s1.getHash());
+	large.insert(999);
+	ASSERT(large != s1);
+	ASSERT(large.remove(999));
+	ASSERT(!large.remove(999));
+	ASSERT(large == s1);
+	DenseBitSet copy = large;
+	copy.clear();
+	ASSERT(copy.isEmpty());
+	ASSERT_EQUAL(2, large.size());
+}
+
+void testSparseSet()
+{
+	SparseSet s(10);
+	ASSERT(s.isEmpty());
+	ASSERT(s.insert(7));
+	ASSERT(s.insert(2));
+	ASSERT(!s.insert(7));
+	ASSERT(s.contains(7));
+	ASSERT(!s.contains(3));
+	ASSERT_EQUAL(2, s.size());
+	// insertion order
+	ASSERT_EQUAL(7, s[0]);
+	ASSERT_EQUAL(2, s[1]);
+	s.clear();
+	ASSERT(!s.contains(7));
+	ASSERT(s.insert(2));
+	ASSERT_EQUAL(1, std::distance(s.begin(), s.end()));
+	SparseSet other(10);
+	other.insert(9);
+	s.swap(other);
+	ASSERT(s.contains(9));
+	ASSERT(other.contains(2));
+}
+
+void testRefinablePartition()
+{
+	// {0, 2, 4, 5} {1, 3} and an empty set
+	std::vector<size_t> keys = { 0, 1, 0, 1, 0, 0 };
+	RefinablePartition p(keys, 3);
+	ASSERT_EQUAL(3, p.size());
+	ASSERT_EQUAL(4, p.setSize(0));
+	ASSERT_EQUAL(0, p.setSize(2));
+	ASSERT_EQUAL(1, p.find(3));
+	// the marked part is the smaller one
+	p.mark(4);
+	p.mark(4);
+	p.split();
+	ASSERT_EQUAL(4, p.size());
+	ASSERT_EQUAL(3, p.find(4));
+	ASSERT_EQUAL(3, p.setSize(0));
+	// the unmarked part is
+	p.mark(0);
+	p.mark(2);
+	p.split();
+	ASSERT_EQUAL(5, p.size());
+	ASSERT_EQUAL(0, p.find(0));
+	ASSERT_EQUAL(4, p.find(5));
+	// a set marked entirely is kept, marks are cleared
+	p.mark(0);
+	p.mark(2);
+	p.split();
+	ASSERT_EQUAL(5, p.size());
+	p.mark(3);
+	p.split();
+	ASSERT_EQUAL(6, p.size());
+	ASSERT_EQUAL(5, p.find(3));
+	ASSERT_EQUAL(1, p.find(1));
+	ASSERT_EQUAL(1, *p.begin(1));
+}
+
 // Test suits
 
 void containersSuit()
@@ -233,5 +488,11 @@ void containersSuit()
 	s += CUTE(testSubstraction);
 	s += CUTE(testSetNested);
 	s += CUTE(testCoW);
+	s += CUTE(testSetInlineStorage);
+	s += CUTE(testSetHash);
+	s += CUTE(testSetInterner);
+	s += CUTE(testDenseBitSet);
+	s += CUTE(testSparseSet);
+	s += CUTE(testRefinablePartition);
 	cute::runner<cute::ostream_listener>()(s, "Containers Test");
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+/************************************************************************/
+/*  Test Dense DFA
+/************************************************************************/
+
+#include "parser.h"
+#include "simplifier.h"
+#include "densedfa.h"
+#include "cute/cute.h"
+
+Automata compileDFA(const char* pattern)
+{
+	Automata a;
+	Parser<UTF8>(pattern, a);
+	a = Simplifier::NFAToDFA(a);
+	return Simplifier::MinimizeDFA(a);
+}
+
+void testDenseMatch()
+{
+	DenseDFA dfa(compileDFA("(a|b)*abb"));
+	ASSERT(dfa.match<ASCII>("babb", 4));
+	ASSERT(dfa.match<ASCII>("baaaaaabb", 9));
+	ASSERT(dfa.match<ASCII>("aaabbbbababababb", 16));
+	ASSERT(dfa.match<ASCII>("abb", 3));
+	ASSERT(!dfa.match<ASCII>("abbacbb", 7));
+	ASSERT(!dfa.match<ASCII>("babba", 5));
+	ASSERT(!dfa.match<ASCII>("", 0));
+	ASSERT(!dfa.match<ASCII>("b", 1));
+}
+
+void testDenseSymbolClasses()
+{
+	DenseDFA dfa(compileDFA("\\d+x"));
+	// digits, 'x', everything else
+	ASSERT_EQUAL(3, dfa.getClassCount());
+	ASSERT_EQUAL(dfa.classOf('0'), dfa.classOf('7'));
+	ASSERT(dfa.classOf('x') != dfa.classOf('y'));
+	ASSERT_EQUAL(dfa.classOf('y'), dfa.classOf(0x4e07u));
+	ASSERT(dfa.match<ASCII>("0123x", 5));
+	ASSERT(!dfa.match<ASCII>("x", 1));
+	ASSERT(!dfa.match<ASCII>("12a", 3));
+}
+
+void testDenseUnicode()
+{
+	DenseDFA dfa(compileDFA("\xe5\x85\xab+\xe7\x99\xbe\xe4\xb8\x87"));
+	ASSERT(dfa.match<UTF8>("\xe5\x85\xab\xe7\x99\xbe\xe4\xb8\x87", 3));
+	ASSERT(dfa.match<UTF8>("\xe5\x85\xab\xe5\x85\xab\xe7\x99\xbe\xe4\xb8\x87", 4));
+	ASSERT(!dfa.match<UTF8>("\xe7\x99\xbe\xe4\xb8\x87", 2));
+}
+
+void testDenseWildcard()
+{
+	DenseDFA dfa(compileDFA("a.c"));
+	ASSERT(dfa.match<ASCII>("abc", 3));
+	ASSERT(dfa.match<ASCII>("a-c", 3));
+	ASSERT(!dfa.match<ASCII>("ac", 2));
+	ASSERT(!dfa.match<ASCII>("abcc", 4));
+}
+
+void testDenseEmptyAndIllegal()
+{
+	Automata empty;
+	DenseDFA dfa(empty);
+	ASSERT_EQUAL(1, dfa.size());
+	ASSERT(!dfa.match<ASCII>("", 0));
+	ASSERT(!dfa.match<ASCII>("a", 1));
+
+	// not deterministic : two edges on 'a'
+	Automata nfa;
+	nfa.generateState();
+	nfa.generateState();
+	nfa.generateState();
+	nfa.addTransition(0, 1, static_cast<HRegexByte>('a'));
+	nfa.addTransition(0, 2, static_cast<HRegexByte>('a'));
+	nfa.setStart(0);
+	ASSERT_THROWS(DenseDFA{ nfa }, IllegalStateError);
+
+	// epsilon edges are not allowed either
+	Automata eps;
+	eps.generateState();
+	eps.generateState();
+	eps.addTransition(0, 1, Transition::EPSILON);
+	eps.setStart(0);
+	ASSERT_THROWS(DenseDFA{ eps }, IllegalStateError);
+}
+
+// Test suits
+
+void denseDFASuit()
+{
+	cute::suite s;
+	s += CUTE(testDenseMatch);
+	s += CUTE(testDenseSymbolClasses);
+	s += CUTE(testDenseUnicode);
+	s += CUTE(testDenseWildcard);
+	s += CUTE(testDenseEmptyAndIllegal);
+	cute::runner<cute::ostream_listener>()(s, "Dense DFA Test");
+}
\ No newline at end of file
@@ -91,11 +91,25 @@ void testUTF16()
 #endif
 }
 
+void testRaw()
+{
+	const char d1[] = { 'a', 0x00, 0xe5u, 0x85u, 0xabu };
+	StreamReader<RAW> reader(d1);
+	ASSERT_EQUAL('a', reader.peek());
+	ASSERT_EQUAL('a', reader.next());
+	ASSERT_EQUAL(0, reader.next());
+	ASSERT_EQUAL(0xe5u, reader.next());
+	ASSERT_EQUAL(0x85u, reader.peek());
+	ASSERT_EQUAL(0x85u, reader.next());
+	ASSERT_EQUAL(0xabu, reader.next());
+}
+
 void testIllegalOperation()
 {
 	ASSERT_THROWS(StreamReader<ASCII>(0), NullPointerError);
 	ASSERT_THROWS(StreamReader<UTF16>(0), NullPointerError);
 	ASSERT_THROWS(StreamReader<UTF8>(0), NullPointerError);
+	ASSERT_THROWS(StreamReader<RAW>(0), NullPointerError);
 
 	StreamReader<ASCII> reader("hello");
 	StreamReader<UTF8> reader2("world");
@@ -119,6 +133,7 @@ void encodingSuit()
 	s += CUTE(testASCII);
 	s += CUTE(testUTF8);
 	s += CUTE(testUTF16);
+	s += CUTE(testRaw);
 	s += CUTE(testIllegalOperation);
 	cute::runner<cute::ostream_listener>()(s, "Encoding Test");
 }
\ No newline at end of file
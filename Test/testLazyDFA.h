@@ -0,0 +1,109 @@
+/************************************************************************/
+/*  Test Lazy DFA
+/************************************************************************/
+
+#include "parser.h"
+#include "lazydfa.h"
+#include "cute/cute.h"
+
+void testLazyMatch()
+{
+	Automata nfa;
+	Parser<ASCII>("(a|b)*abb", nfa);
+	LazyDFA dfa(nfa);
+	ASSERT(dfa.match<ASCII>("babb", 4));
+	ASSERT(dfa.match<ASCII>("baaaaaabb", 9));
+	ASSERT(dfa.match<ASCII>("aaabbbbababababb", 16));
+	ASSERT(dfa.match<ASCII>("abb", 3));
+	ASSERT(!dfa.match<ASCII>("abbacbb", 7));
+	ASSERT(!dfa.match<ASCII>("babba", 5));
+	ASSERT(!dfa.match<ASCII>("", 0));
+	ASSERT(!dfa.match<ASCII>("b", 1));
+	// only the subsets visited above are built : dead + at most 5
+	ASSERT(dfa.size() <= 6);
+}
+
+void testLazyOverlappingTransitions()
+{
+	Automata nfa;
+	Parser<ASCII>(".*a\\d|b", nfa);
+	LazyDFA dfa(nfa);
+	ASSERT(dfa.match<ASCII>("xxa1", 4));
+	ASSERT(dfa.match<ASCII>("aa1", 3));
+	ASSERT(dfa.match<ASCII>("b", 1));
+	ASSERT(!dfa.match<ASCII>("xxa", 3));
+	ASSERT(!dfa.match<ASCII>("bb", 2));
+}
+
+void testLazyExponentialPattern()
+{
+	// the eager DFA of this pattern has about 2^21 states
+	Automata nfa;
+	Parser<ASCII>("(a|b)*a(a|b){20}", nfa);
+	LazyDFA dfa(nfa);
+	std::string input;
+	for (int i = 0; i != 200; ++i)
+	{
+		input += (i * 7 % 3 == 0) ? 'a' : 'b';
+	}
+	std::string yes = input + "a" + std::string(20, 'b');
+	std::string no = input + "b" + std::string(20, 'b');
+	ASSERT(dfa.match<ASCII>(yes.c_str(), yes.size()));
+	ASSERT(!dfa.match<ASCII>(no.c_str(), no.size()));
+	ASSERT(dfa.size() <= yes.size() + no.size() + 2);
+}
+
+void testLazyCacheBudget()
+{
+	Automata nfa;
+	Parser<ASCII>("(a|b)*a(a|b){20}", nfa);
+	// room for a handful of states only
+	LazyDFA dfa(nfa, ALL_MATCHES, 2048);
+	std::string input;
+	for (int i = 0; i != 500; ++i)
+	{
+		input += (i * i % 5 < 2) ? 'a' : 'b';
+	}
+	for (int tail = 0; tail != 2; ++tail)
+	{
+		std::string s = input + (tail ? "a" : "b") + std::string(20, 'a');
+		ASSERT_EQUAL(nfa.simulate<ASCII>(s.c_str(), s.size()), dfa.match<ASCII>(s.c_str(), s.size()));
+		ASSERT(dfa.getMemoryUsage() <= 2048);
+	}
+	ASSERT(dfa.getFlushCount() > 0);
+}
+
+void testLazyCacheFootprint()
+{
+	// the pool's blocks and slot table count, and are freed by a flush
+	Automata nfa;
+	Parser<ASCII>("(a|b)*a(a|b){12}", nfa);
+	const MatchKind kinds[] = { ALL_MATCHES, LEFTMOST_FIRST };
+	for (auto kind : kinds)
+	{
+		LazyDFA dfa(nfa, kind, 8192);
+		LazyDFA::CachedState current = dfa.getStart();
+		size_t largest = 0;
+		for (unsigned i = 0, x = 1; i != 20000 && current != LazyDFA::DEAD; ++i)
+		{
+			x = x * 1103515245 + 12345;
+			current = dfa.next(current, ((x >> 16) & 1) ? 'a' : 'b');
+			largest = std::max(largest, dfa.getMemoryUsage());
+		}
+		ASSERT(largest <= 8192);
+		ASSERT(dfa.getFlushCount() > 10);
+	}
+}
+
+// Test suits
+
+void lazyDFASuit()
+{
+	cute::suite s;
+	s += CUTE(testLazyMatch);
+	s += CUTE(testLazyOverlappingTransitions);
+	s += CUTE(testLazyExponentialPattern);
+	s += CUTE(testLazyCacheBudget);
+	s += CUTE(testLazyCacheFootprint);
+	cute::runner<cute::ostream_listener>()(s, "Lazy DFA Test");
+}
\ No newline at end of file
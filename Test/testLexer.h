@@ -0,0 +1,98 @@
+/************************************************************************/
+/*  Test Lexer
+/************************************************************************/
+
+#include "lexer.h"
+#include "cute/cute.h"
+
+enum
+{
+	TOKEN_IF,
+	TOKEN_IDENTIFIER,
+	TOKEN_NUMBER,
+	TOKEN_OPERATOR,
+	TOKEN_SPACE
+};
+
+Lexer dslLexer()
+{
+	return Lexer({ "if", "(a|b|c|d|e|f|i|x|y)+", "\\d+(\\.\\d+)?", "=|==|<|<=", "( |\t)+" });
+}
+
+void testLexerTokens()
+{
+	Lexer lexer = dslLexer();
+	std::string code = "if x1 <= 3.25";
+	auto tokens = lexer.tokenize(code.c_str(), code.size());
+	ASSERT_EQUAL(8, tokens.size());
+	ASSERT_EQUAL(TOKEN_IF, tokens[0].id);
+	ASSERT_EQUAL(TOKEN_SPACE, tokens[1].id);
+	ASSERT_EQUAL(TOKEN_IDENTIFIER, tokens[2].id);
+	ASSERT_EQUAL(TOKEN_NUMBER, tokens[3].id);
+	ASSERT_EQUAL(4, tokens[3].offset);
+	ASSERT_EQUAL(1, tokens[3].length);
+	ASSERT_EQUAL(TOKEN_OPERATOR, tokens[5].id);
+	ASSERT_EQUAL(2, tokens[5].length);
+	ASSERT_EQUAL(TOKEN_NUMBER, tokens[7].id);
+	ASSERT_EQUAL(9, tokens[7].offset);
+	ASSERT_EQUAL(4, tokens[7].length);
+}
+
+void testLexerPriority()
+{
+	Lexer lexer = dslLexer();
+	Token token;
+	// same length : the first rule wins
+	ASSERT(lexer.nextToken("if", 2, 0, token));
+	ASSERT_EQUAL(TOKEN_IF, token.id);
+	// longer match wins over rule order
+	ASSERT(lexer.nextToken("iffy", 4, 0, token));
+	ASSERT_EQUAL(TOKEN_IDENTIFIER, token.id);
+	ASSERT_EQUAL(4, token.length);
+	// backs off to the last accepting position
+	ASSERT(lexer.nextToken("3.x", 3, 0, token));
+	ASSERT_EQUAL(TOKEN_NUMBER, token.id);
+	ASSERT_EQUAL(1, token.length);
+	ASSERT(!lexer.nextToken("3.x", 3, 3, token));
+}
+
+void testLexerError()
+{
+	Lexer lexer = dslLexer();
+	ASSERT_THROWS(lexer.tokenize("x = z", 5), LexError);
+	ASSERT(lexer.tokenize("", 0).empty());
+	// rules matching the empty string never give empty tokens
+	Lexer optional({ "a*" });
+	ASSERT_EQUAL(1, optional.tokenize("aaa", 3).size());
+	ASSERT_THROWS(optional.tokenize("b", 1), LexError);
+}
+
+void testLexerRescan()
+{
+	// every "a" would scan to the end of the run without the dead pairs
+	Lexer lexer({ "a*b", "a" });
+	std::string run(200000, 'a');
+	auto tokens = lexer.tokenize(run.c_str(), run.size());
+	ASSERT_EQUAL(run.size(), tokens.size());
+	ASSERT_EQUAL(1, tokens.back().id);
+	ASSERT_EQUAL(run.size() - 1, tokens.back().offset);
+	// the dead pairs of one run do not hide a later token
+	std::string text = "aaaaab" + run.substr(0, 5) + "aab";
+	tokens = lexer.tokenize(text.c_str(), text.size());
+	ASSERT_EQUAL(2, tokens.size());
+	ASSERT_EQUAL(0, tokens[0].id);
+	ASSERT_EQUAL(6, tokens[0].length);
+	ASSERT_EQUAL(8, tokens[1].length);
+}
+
+// Test suits
+
+void lexerSuit()
+{
+	cute::suite s;
+	s += CUTE(testLexerTokens);
+	s += CUTE(testLexerPriority);
+	s += CUTE(testLexerError);
+	s += CUTE(testLexerRescan);
+	cute::runner<cute::ostream_listener>()(s, "Lexer Test");
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+/************************************************************************/
+/*  Test one-pass DFA
+/************************************************************************/
+
+#include "onepass.h"
+#include "pikevm.h"
+#include "cute/cute.h"
+
+void testOnePassDetection()
+{
+	ASSERT(OnePassDFA("(\\d+)-(\\d+)").isOnePass());
+	ASSERT(OnePassDFA("(a*)b").isOnePass());
+	ASSERT(OnePassDFA("(ab|cd)+").isOnePass());
+	ASSERT(OnePassDFA("x(\xe7\x99\xbe+)").isOnePass());
+	ASSERT(!OnePassDFA("(a|ab)c").isOnePass());
+	ASSERT(!OnePassDFA("(a*)(a*)").isOnePass());
+	ASSERT(!OnePassDFA("a*a").isOnePass());
+	OnePassDFA ambiguous("(a|ab)c");
+	std::vector<size_t> caps;
+	ASSERT_THROWS(ambiguous.match("abc", 3, caps), IllegalStateError);
+}
+
+void testOnePassCaptures()
+{
+	std::vector<size_t> caps;
+	OnePassDFA range("(\\d+)-(\\d+)");
+	ASSERT_EQUAL(3, range.getGroupCount());
+	ASSERT(range.match("12-345", 6, caps));
+	ASSERT_EQUAL(0, caps[0]);
+	ASSERT_EQUAL(6, caps[1]);
+	ASSERT_EQUAL(0, caps[2]);
+	ASSERT_EQUAL(2, caps[3]);
+	ASSERT_EQUAL(3, caps[4]);
+	ASSERT_EQUAL(6, caps[5]);
+	ASSERT(!range.match("12-345x", 7, caps));
+	ASSERT(!range.match("12-", 3, caps));
+
+	// a group that did not take part is unset
+	OnePassDFA alternate("(a)|(b)");
+	ASSERT(alternate.isOnePass());
+	ASSERT(alternate.match("b", 1, caps));
+	ASSERT_EQUAL(OnePassDFA::NONE, caps[2]);
+	ASSERT_EQUAL(0, caps[4]);
+	ASSERT_EQUAL(1, caps[5]);
+
+	// the last iteration is kept
+	OnePassDFA repeat("(ab)+");
+	ASSERT(repeat.match("ababab", 6, caps));
+	ASSERT_EQUAL(4, caps[2]);
+	ASSERT_EQUAL(6, caps[3]);
+}
+
+void testOnePassAgreesWithPikeVM()
+{
+	const char* patterns[] = { "(\\d+)-(\\d+)", "(a*)b", "(ab|cd)+(e?)", "k(\\d{1,3})=(.)" };
+	const char* texts[] = { "", "b", "aab", "1-2", "99-", "abcde", "abcd", "k12=z", "k1234=z", "k1=\n" };
+	std::vector<size_t> expected;
+	std::vector<size_t> actual;
+	for (auto p : patterns)
+	{
+		OnePassDFA onePass(p);
+		PikeVM vm(p);
+		ASSERT(onePass.isOnePass());
+		for (auto t : texts)
+		{
+			size_t len = strlen(t);
+			bool matched = vm.match(t, len, expected);
+			ASSERT_EQUAL(matched, onePass.match(t, len, actual));
+			if (matched)
+			{
+				ASSERT_EQUAL(expected, actual);
+			}
+		}
+	}
+}
+
+// Test suits
+
+void onePassSuit()
+{
+	cute::suite s;
+	s += CUTE(testOnePassDetection);
+	s += CUTE(testOnePassCaptures);
+	s += CUTE(testOnePassAgreesWithPikeVM);
+	cute::runner<cute::ostream_listener>()(s, "One-pass DFA Test");
+}
\ No newline at end of file
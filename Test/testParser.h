@@ -2,6 +2,7 @@
 /*  Test Regex Parser
 /************************************************************************/
 
+#include <cstring>
 #include "parser.h"
 #include "cute/cute.h"
 
@@ -210,6 +211,72 @@ void testRegexTogether()
 	ASSERT(!nfa.simulate<ASCII>("1222a93", 7));
 }
 
+std::string prefixOf(const char* pattern)
+{
+	Automata nfa;
+	Parser<ASCII> parser(pattern, nfa);
+	std::vector<UnicodeChar> prefix;
+	parser.getAST()->literalPrefix(prefix);
+	return std::string(prefix.begin(), prefix.end());
+}
+
+void testLiteralPrefix()
+{
+	ASSERT_EQUAL("abc", prefixOf("abc"));
+	ASSERT_EQUAL("ERROR: ", prefixOf("ERROR: .*timeout"));
+	ASSERT_EQUAL("ab", prefixOf("ab+c"));
+	ASSERT_EQUAL("a", prefixOf("ab*c"));
+	ASSERT_EQUAL("abab", prefixOf("(ab){2,3}c"));
+	ASSERT_EQUAL("ababc", prefixOf("(ab){2}c"));
+	ASSERT_EQUAL("GET /", prefixOf("GET /a|GET /b"));
+	ASSERT_EQUAL("", prefixOf("a?b"));
+	ASSERT_EQUAL("", prefixOf("\\d+x"));
+	Automata nfa;
+	ASSERT(!Parser<ASCII>("", nfa).getAST());
+}
+
+void testGlushkov()
+{
+	Automata nfa;
+	// one state per character plus the start state, no epsilon edge
+	Parser<ASCII>("(ab|a)*\\dc?", nfa, GLUSHKOV);
+	ASSERT_EQUAL(6, nfa.size());
+	for (State s = 0; s != nfa.size(); ++s)
+	{
+		auto& edges = nfa.getNeighbours(s);
+		for (auto e = edges.begin(); e != edges.end(); ++e)
+		{
+			ASSERT(e->getTransition().getType() != Transition::EPSILON);
+		}
+	}
+	// the nested loop follows the same positions again, no edge twice
+	Parser<ASCII>("((a|b)*)*(a|b)*", nfa, GLUSHKOV);
+	size_t edgeCount = 0;
+	for (State s = 0; s != nfa.size(); ++s)
+	{
+		edgeCount += nfa.getNeighbours(s).size();
+	}
+	ASSERT_EQUAL(16, edgeCount);
+	Parser<ASCII>("", nfa, GLUSHKOV);
+	ASSERT_EQUAL(0, nfa.size());
+
+	// same language as the Thompson automata
+	const char* patterns[] = { "(ab|a)*\\dc?", "a{2,3}b{2,}", "(a*)*", "a?|b{0,2}", "(.b)+|c" };
+	const char* texts[] = { "", "a", "b", "ab", "aab", "aaab", "abbb", "1", "ab1c", "aaba9",
+		"aaaabbb", "bb", "bbb", "cb", "xbab", "c" };
+	for (auto p : patterns)
+	{
+		Automata thompson;
+		Automata glushkov;
+		Parser<ASCII>(p, thompson);
+		Parser<ASCII>(p, glushkov, GLUSHKOV);
+		for (auto t : texts)
+		{
+			ASSERT_EQUAL(thompson.simulate<ASCII>(t, strlen(t)), glushkov.simulate<ASCII>(t, strlen(t)));
+		}
+	}
+}
+
 void parserSuit()
 {
 	cute::suite s;
@@ -225,5 +292,7 @@ void parserSuit()
 	s += CUTE(testDigit);
 	s += CUTE(testEscape);
 	s += CUTE(testRegexTogether);
+	s += CUTE(testLiteralPrefix);
+	s += CUTE(testGlushkov);
 	cute::runner<cute::ostream_listener>()(s, "Regex Parser Test");
-}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+/************************************************************************/
+/*  Test Pike VM
+/************************************************************************/
+
+#include "pikevm.h"
+#include "cute/cute.h"
+
+void testPikeCaptures()
+{
+	PikeVM vm("(a+)(b+)");
+	ASSERT_EQUAL(3, vm.getGroupCount());
+	std::vector<size_t> caps;
+	ASSERT(vm.find("xaabbby", 7, caps));
+	ASSERT_EQUAL(6, caps.size());
+	ASSERT_EQUAL(1, caps[0]);
+	ASSERT_EQUAL(6, caps[1]);
+	ASSERT_EQUAL(1, caps[2]);
+	ASSERT_EQUAL(3, caps[3]);
+	ASSERT_EQUAL(3, caps[4]);
+	ASSERT_EQUAL(6, caps[5]);
+	ASSERT(!vm.find("xaay", 4, caps));
+}
+
+void testPikeLeftmostFirst()
+{
+	std::vector<size_t> caps;
+	PikeVM vm("(a|ab)(c|bcd)(d*)");
+	ASSERT(vm.find("abcd", 4, caps));
+	ASSERT_EQUAL(0, caps[0]);
+	ASSERT_EQUAL(4, caps[1]);
+	ASSERT_EQUAL(1, caps[3]);
+	ASSERT_EQUAL(4, caps[5]);
+	ASSERT_EQUAL(4, caps[6]);
+	ASSERT_EQUAL(4, caps[7]);
+
+	// the group that did not take part is unset
+	PikeVM alternate("(a)|(b)");
+	ASSERT(alternate.find("b", 1, caps));
+	ASSERT_EQUAL(PikeVM::NONE, caps[2]);
+	ASSERT_EQUAL(PikeVM::NONE, caps[3]);
+	ASSERT_EQUAL(0, caps[4]);
+	ASSERT_EQUAL(1, caps[5]);
+
+	// the last iteration is kept
+	PikeVM repeat("(ab)+");
+	ASSERT(repeat.find("ababab", 6, caps));
+	ASSERT_EQUAL(4, caps[2]);
+	ASSERT_EQUAL(6, caps[3]);
+}
+
+void testPikeFullMatch()
+{
+	std::vector<size_t> caps;
+	PikeVM vm("(\\d+)-(\\d+)");
+	ASSERT(vm.match("12-345", 6, caps));
+	ASSERT_EQUAL(0, caps[2]);
+	ASSERT_EQUAL(2, caps[3]);
+	ASSERT_EQUAL(3, caps[4]);
+	ASSERT_EQUAL(6, caps[5]);
+	ASSERT(!vm.match("12-345x", 7, caps));
+	ASSERT(!vm.match("x12-345", 7, caps));
+	// a full match is not the leftmost-first one
+	PikeVM lazy("(a|ab)(b*)");
+	ASSERT(lazy.match("abb", 3, caps));
+	ASSERT_EQUAL(1, caps[3]);
+	ASSERT_EQUAL(3, caps[5]);
+}
+
+void testPikeUTF8AndBlowup()
+{
+	std::vector<size_t> caps;
+	// U+767E
+	PikeVM vm("x(\xe7\x99\xbe+)");
+	ASSERT(vm.find("ax\xe7\x99\xbe\xe7\x99\xbe", 8, caps));
+	ASSERT_EQUAL(2, caps[2]);
+	ASSERT_EQUAL(8, caps[3]);
+	// exponential for a backtracker
+	PikeVM blowup("(a*)*b");
+	std::string text(5000, 'a');
+	ASSERT(!blowup.find(text.c_str(), text.size(), caps));
+}
+
+// Test suits
+
+void pikeVMSuit()
+{
+	cute::suite s;
+	s += CUTE(testPikeCaptures);
+	s += CUTE(testPikeLeftmostFirst);
+	s += CUTE(testPikeFullMatch);
+	s += CUTE(testPikeUTF8AndBlowup);
+	cute::runner<cute::ostream_listener>()(s, "Pike VM Test");
+}
\ No newline at end of file
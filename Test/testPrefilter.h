@@ -0,0 +1,74 @@
+/************************************************************************/
+/*  Test Literal Prefilter
+/************************************************************************/
+
+#include "parser.h"
+#include "prefilter.h"
+#include "cute/cute.h"
+
+LiteralPrefilter prefilterOf(const char* pattern)
+{
+	Automata nfa;
+	Parser<UTF8> parser(pattern, nfa);
+	return LiteralPrefilter(parser.getAST());
+}
+
+void testRequiredLiterals()
+{
+	Automata nfa;
+	Parser<ASCII> parser("ab\\d+ms user=x(yz)*", nfa);
+	std::vector<RequiredLiteral> literals;
+	parser.getAST()->requiredLiterals(literals);
+	ASSERT_EQUAL(2, literals.size());
+	ASSERT_EQUAL("ab", std::string(literals[0].literal.begin(), literals[0].literal.end()));
+	ASSERT(!literals[0].before);
+	ASSERT_EQUAL("ms user=x", std::string(literals[1].literal.begin(), literals[1].literal.end()));
+	ASSERT(literals[1].before);
+}
+
+void testChooseRarest()
+{
+	ASSERT(prefilterOf("\\d+").isEmpty());
+	ASSERT(prefilterOf("a|b").isEmpty());
+	ASSERT_EQUAL("GET /api/", prefilterOf("GET /api/\\d+").getLiteral());
+	// 'q' is rarer than anything in "error "
+	ASSERT_EQUAL("q", prefilterOf("error \\d+q").getLiteral());
+	ASSERT_EQUAL("ms user=alice", prefilterOf("\\d+ms user=alice").getLiteral());
+	// the part before can match "ab", so an earlier occurrence could be
+	// skipped over : not usable
+	ASSERT(prefilterOf("(a|b)*ab").isEmpty());
+	// overlapping occurrences : not usable either
+	ASSERT(prefilterOf("\\d+xyx").isEmpty());
+	// bounded part before, always usable
+	ASSERT_EQUAL("xyx", prefilterOf("\\d\\dxyx").getLiteral());
+	// a group is what it holds
+	ASSERT_EQUAL("ms user=alice", prefilterOf("(\\d+ms user=alice)").getLiteral());
+	ASSERT_EQUAL("GET /api/", prefilterOf("((GET /api/\\d+))").getLiteral());
+}
+
+void testNextStart()
+{
+	const HRegexByte* text = reinterpret_cast<const HRegexByte*>("a 12ms user=bob 345ms user=alice");
+	LiteralPrefilter::Cursor cursor;
+	LiteralPrefilter unbounded = prefilterOf("\\d+ms user=alice");
+	ASSERT_EQUAL(16, unbounded.nextStart(text, 0, 32, cursor));
+	// a shorter number still reaches the literal
+	ASSERT_EQUAL(17, unbounded.nextStart(text, 17, 32, cursor));
+	ASSERT_EQUAL(32, unbounded.nextStart(text, 20, 32, cursor));
+
+	LiteralPrefilter bounded = prefilterOf("\\d\\dms user=alice");
+	cursor = LiteralPrefilter::Cursor();
+	ASSERT_EQUAL(17, bounded.nextStart(text, 0, 32, cursor));
+	ASSERT_EQUAL(18, bounded.nextStart(text, 18, 32, cursor));
+}
+
+// Test suits
+
+void prefilterSuit()
+{
+	cute::suite s;
+	s += CUTE(testRequiredLiterals);
+	s += CUTE(testChooseRarest);
+	s += CUTE(testNextStart);
+	cute::runner<cute::ostream_listener>()(s, "Literal Prefilter Test");
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+/************************************************************************/
+/*  Test Regex Set
+/************************************************************************/
+
+#include "regexset.h"
+#include "cute/cute.h"
+
+void testRegexSetMatches()
+{
+	RegexSet set({ "timeout", "\\d+ms", "ERROR", "user=(alice|bob)" });
+	ASSERT_EQUAL(4, set.size());
+	std::string line = "ERROR: 120ms user=bob timeout";
+	auto ids = set.matches(line.c_str(), line.size());
+	ASSERT_EQUAL(4, ids.size());
+	ASSERT_EQUAL(0, ids[0]);
+	ASSERT_EQUAL(3, ids[3]);
+	line = "INFO: 5ms user=carol";
+	ids = set.matches(line.c_str(), line.size());
+	ASSERT_EQUAL(1, ids.size());
+	ASSERT_EQUAL(1, ids[0]);
+	ASSERT(set.isMatch(line.c_str(), line.size()));
+	line = "INFO: ok";
+	ASSERT(set.matches(line.c_str(), line.size()).empty());
+	ASSERT(!set.isMatch(line.c_str(), line.size()));
+}
+
+void testRegexSetLabels()
+{
+	// same language, the labels keep them apart
+	RegexSet same({ "ab", "a(b)", "abc" });
+	auto ids = same.matches("xabx", 4);
+	ASSERT_EQUAL(2, ids.size());
+	ASSERT_EQUAL(0, ids[0]);
+	ASSERT_EQUAL(1, ids[1]);
+	ids = same.matches("abc", 3);
+	ASSERT_EQUAL(3, ids.size());
+
+	// U+767E
+	RegexSet unicode({ "\xe7\x99\xbe+", "." });
+	ids = unicode.matches("\xe7\x99\xbe", 3);
+	ASSERT_EQUAL(2, ids.size());
+	// an invalid byte is not a character
+	ASSERT(!unicode.isMatch("\xff", 1));
+}
+
+void testRegexSetEmpty()
+{
+	RegexSet empty({});
+	ASSERT_EQUAL(0, empty.size());
+	ASSERT(!empty.isMatch("abc", 3));
+	RegexSet withEmptyPattern({ "", "b" });
+	auto ids = withEmptyPattern.matches("abc", 3);
+	ASSERT_EQUAL(1, ids.size());
+	ASSERT_EQUAL(1, ids[0]);
+}
+
+// Test suits
+
+void regexSetSuit()
+{
+	cute::suite s;
+	s += CUTE(testRegexSetMatches);
+	s += CUTE(testRegexSetLabels);
+	s += CUTE(testRegexSetEmpty);
+	cute::runner<cute::ostream_listener>()(s, "Regex Set Test");
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+/************************************************************************/
+/*  Test Unanchored Search
+/************************************************************************/
+
+#include "search.h"
+#include "cute/cute.h"
+
+void testFind()
+{
+	Searcher searcher("b+c");
+	Match m;
+	ASSERT(searcher.find("aabbbcdd", 8, m));
+	ASSERT_EQUAL(2, m.start);
+	ASSERT_EQUAL(6, m.end);
+	ASSERT(!searcher.find("aabbbd", 6, m));
+	ASSERT(!searcher.find("", 0, m));
+	// restart from an offset
+	ASSERT(searcher.find("bcxbbc", 6, m, 1));
+	ASSERT_EQUAL(3, m.start);
+	ASSERT_EQUAL(6, m.end);
+}
+
+void testFindLeftmostFirst()
+{
+	Match m;
+	// the first alternative wins, not the longest one
+	Searcher first("a|ab");
+	ASSERT(first.find("xab", 3, m));
+	ASSERT_EQUAL(1, m.start);
+	ASSERT_EQUAL(2, m.end);
+	Searcher longest("ab|a");
+	ASSERT(longest.find("xab", 3, m));
+	ASSERT_EQUAL(1, m.start);
+	ASSERT_EQUAL(3, m.end);
+	// the leftmost start wins over a shorter match ending earlier
+	Searcher leftmost("abcd|c");
+	ASSERT(leftmost.find("abcd", 4, m));
+	ASSERT_EQUAL(0, m.start);
+	ASSERT_EQUAL(4, m.end);
+	Searcher greedy("a+");
+	ASSERT(greedy.find("baaab", 5, m));
+	ASSERT_EQUAL(1, m.start);
+	ASSERT_EQUAL(4, m.end);
+}
+
+void testFindAll()
+{
+	Searcher searcher("\\d+");
+	auto all = searcher.findAll("a1b22c333", 9);
+	ASSERT_EQUAL(3, all.size());
+	ASSERT(all[0] == Match({ 1, 2 }));
+	ASSERT(all[1] == Match({ 3, 5 }));
+	ASSERT(all[2] == Match({ 6, 9 }));
+
+	// empty matches, one per position
+	Searcher empty("a*");
+	all = empty.findAll("baa", 3);
+	ASSERT_EQUAL(3, all.size());
+	ASSERT(all[0] == Match({ 0, 0 }));
+	ASSERT(all[1] == Match({ 1, 3 }));
+	ASSERT(all[2] == Match({ 3, 3 }));
+}
+
+void testFindUTF8Offsets()
+{
+	// U+516B U+767E
+	Searcher searcher("\xe7\x99\xbe+");
+	const char* text = "\xe5\x85\xab\xe7\x99\xbe\xe7\x99\xbe" "a";
+	Match m;
+	ASSERT(searcher.find(text, 10, m));
+	ASSERT_EQUAL(3, m.start);
+	ASSERT_EQUAL(9, m.end);
+
+	// an empty match never splits a character
+	Searcher empty("x*");
+	auto all = empty.findAll("\xe5\x85\xab" "a", 4);
+	ASSERT_EQUAL(3, all.size());
+	ASSERT(all[1] == Match({ 3, 3 }));
+	ASSERT(all[2] == Match({ 4, 4 }));
+}
+
+void testMatchIterator()
+{
+	Searcher searcher("ab");
+	std::string text;
+	for (int i = 0; i != 10000; ++i)
+	{
+		text += "xxab";
+	}
+	auto it = searcher.iterate(text.c_str(), text.size());
+	Match m;
+	size_t count = 0;
+	while (it.next(m))
+	{
+		ASSERT_EQUAL(count * 4 + 2, m.start);
+		ASSERT_EQUAL(2, m.length());
+		++count;
+	}
+	ASSERT_EQUAL(10000, count);
+	ASSERT(!it.next(m));
+}
+
+void testFindLazyReverse()
+{
+	// the reversed language needs 2^13 DFA states, more than the dense
+	// limit, so starts are found with the lazy reverse DFA
+	Searcher searcher("(a|b){12}a(a|b)*");
+	Match m;
+	ASSERT(searcher.find("xxbbbbbbbbbbbbabx", 17, m));
+	ASSERT_EQUAL(2, m.start);
+	ASSERT_EQUAL(16, m.end);
+	ASSERT(!searcher.find("xxbbbbbbbbbbbbx", 15, m));
+}
+
+void testFindWithPrefix()
+{
+	Searcher searcher("ERROR: .*timeout");
+	std::string log;
+	for (int i = 0; i != 1000; ++i)
+	{
+		log += "INFO: ok\nWARN: disk full\n";
+	}
+	log += "ERRORS: timeout\nERROR: db timeout\n";
+	Match m;
+	ASSERT(searcher.find(log.c_str(), log.size(), m));
+	ASSERT_EQUAL(log.size() - 18, m.start);
+	ASSERT_EQUAL(log.size() - 1, m.end);
+	// a candidate split by the end of the buffer
+	ASSERT(!searcher.find("xxERROR: time", 13, m));
+	// overlapping candidates
+	Searcher aab("aab");
+	ASSERT(aab.find("aaaab", 5, m));
+	ASSERT_EQUAL(2, m.start);
+	ASSERT_EQUAL(5, m.end);
+}
+
+void testFindWithInnerLiteral()
+{
+	Searcher searcher("\\d+ms user=alice");
+	std::string log;
+	for (int i = 0; i != 1000; ++i)
+	{
+		log += "12ms user=bob\n";
+	}
+	log += "345ms user=alice\n";
+	Match m;
+	ASSERT(searcher.find(log.c_str(), log.size(), m));
+	ASSERT_EQUAL(log.size() - 17, m.start);
+	ASSERT_EQUAL(log.size() - 1, m.end);
+	ASSERT(!searcher.find(log.c_str(), log.size() - 8, m));
+
+	Searcher bounded("\\d\\dxyx");
+	auto all = bounded.findAll("1xyx12xyx123xyxyx", 17);
+	ASSERT_EQUAL(2, all.size());
+	ASSERT(all[0] == Match({ 4, 9 }));
+	ASSERT(all[1] == Match({ 10, 15 }));
+}
+
+// Test suits
+
+void searchSuit()
+{
+	cute::suite s;
+	s += CUTE(testFind);
+	s += CUTE(testFindLeftmostFirst);
+	s += CUTE(testFindAll);
+	s += CUTE(testFindUTF8Offsets);
+	s += CUTE(testMatchIterator);
+	s += CUTE(testFindLazyReverse);
+	s += CUTE(testFindWithPrefix);
+	s += CUTE(testFindWithInnerLiteral);
+	cute::runner<cute::ostream_listener>()(s, "Search Test");
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "parser.h"
 #include "simplifier.h"
+#include "densedfa.h"
 #include "cute/cute.h"
 
 void testNFAToDFA()
@@ -50,6 +51,48 @@ void testNFAToDFA()
 
 }
 
+// no character is accepted by two edges of the same state
+bool isDeterministic(const Automata& dfa)
+{
+	for (State s = 0; s != dfa.size(); ++s)
+	{
+		auto& edges = dfa.getNeighbours(s);
+		for (UnicodeChar ch = 0; ch != 0x3000; ++ch)
+		{
+			if (std::count_if(edges.begin(), edges.end(), [&](const Edge& e)
+			{
+				return e.getTransition().check(ch);
+			}) > 1)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void testNFAToDFAOverlapping()
+{
+	// 'a' and the digits are accepted by two branches each
+	Automata nfa;
+	Parser<UTF8>("ab|.c|\\dd", nfa);
+	Automata dfa = Simplifier::NFAToDFA(nfa);
+	ASSERT(isDeterministic(dfa));
+	ASSERT_EQUAL(3, dfa.getNeighbours(dfa.getStart().last()).size());
+	const char* texts[] = { "ab", "ac", "ad", "1c", "1d", "zc", "zd", "bb", "a", "\xe7\x99\xbe" "c" };
+	for (auto t : texts)
+	{
+		ASSERT_EQUAL(nfa.simulate<UTF8>(t, strlen(t)), dfa.simulate<UTF8>(t, strlen(t)));
+	}
+	// a single edge for the intervals on both sides of 'a'
+	Automata any;
+	Parser<UTF8>("a|.", any);
+	dfa = Simplifier::NFAToDFA(any);
+	ASSERT(isDeterministic(dfa));
+	ASSERT_EQUAL(3, dfa.size());
+	ASSERT_EQUAL(2, dfa.getNeighbours(dfa.getStart().last()).size());
+}
+
 void testMinimizeDFA()
 {
 	// empty DFA
@@ -145,12 +188,216 @@ void testMinimizeDFA()
 	ASSERT(!dfa3.simulate<ASCII>("ab", 2));
 }
 
+void testClassNFAToDFA()
+{
+	// 'a' and . overlap
+	Automata nfa;
+	Parser<ASCII>("ab|.c", nfa);
+	Automata dfa = Simplifier::NFAToDFA(nfa, SymbolClasses(nfa));
+	dfa = Simplifier::MinimizeDFA(dfa);
+	// throws if not deterministic
+	DenseDFA dense(dfa);
+	ASSERT(dense.match<ASCII>("ab", 2));
+	ASSERT(dense.match<ASCII>("ac", 2));
+	ASSERT(dense.match<ASCII>("xc", 2));
+	ASSERT(!dense.match<ASCII>("xb", 2));
+	ASSERT(!dense.match<ASCII>("a", 1));
+
+	Automata large;
+	Parser<ASCII>("(a|b)*a(a|b)(a|b)(a|b)", large);
+	ASSERT_THROWS(Simplifier::NFAToDFA(large, SymbolClasses(large), 8), TooManyStatesError);
+	ASSERT_EQUAL(16, Simplifier::MinimizeDFA(Simplifier::NFAToDFA(large, SymbolClasses(large))).size());
+}
+
+void testStateSetPolicies()
+{
+	// subsets as sorted vectors or as bits : the same DFA
+	const char* patterns[] = { "ab|.c", "(a|b)*a(a|b){3}", "(ab|cd|ef)*(\\d\\d|x+){2,5}" };
+	for (auto p : patterns)
+	{
+		Automata nfa;
+		Parser<ASCII>(p, nfa);
+		SymbolClasses classes(nfa);
+		Automata sorted = Simplifier::NFAToDFA<SortedVectorSet<State>>(nfa, classes);
+		Automata dense = Simplifier::NFAToDFA<DenseBitSet>(nfa, classes);
+		ASSERT_EQUAL(sorted.size(), dense.size());
+		ASSERT_EQUAL(Simplifier::MinimizeDFA(sorted).size(), Simplifier::MinimizeDFA(dense).size());
+		ASSERT_EQUAL(Simplifier::NFAToDFA<SortedVectorSet<State>>(nfa).size(),
+			Simplifier::NFAToDFA<DenseBitSet>(nfa).size());
+		for (State s = 0; s != sorted.size(); ++s)
+		{
+			ASSERT_EQUAL(sorted.isTerminate(s), dense.isTerminate(s));
+			ASSERT_EQUAL(sorted.getNeighbours(s).size(), dense.getNeighbours(s).size());
+		}
+	}
+
+	// Automata's set operations take either
+	Automata nfa;
+	Parser<ASCII>("a*b", nfa);
+	DenseBitSet start(nfa.getStart().begin(), nfa.getStart().end());
+	auto closure = nfa.epsilonClosure(start);
+	auto expected = nfa.epsilonClosure(nfa.getStart());
+	ASSERT(std::equal(expected.begin(), expected.end(), closure.begin()));
+	ASSERT(EpsilonClosures(nfa).closure(start) == closure);
+	auto next = nfa.move(closure, static_cast<UnicodeChar>('b'));
+	ASSERT(nfa.containsTerminate(nfa.epsilonClosure(next)));
+	ASSERT(!nfa.containsTerminate(closure));
+}
+
+void testReverseDFA()
+{
+	Automata nfa;
+	Parser<ASCII>("ab+c", nfa);
+	DenseDFA reversed(Simplifier::ReverseDFA(nfa));
+	ASSERT(reversed.match<ASCII>("cba", 3));
+	ASSERT(reversed.match<ASCII>("cbbba", 5));
+	ASSERT(!reversed.match<ASCII>("abc", 3));
+	ASSERT(!reversed.match<ASCII>("ca", 2));
+}
+
+void testMinimizeKeepsLabels()
+{
+	// a|b where 'a' and 'b' lead to terminate states of different labels
+	Automata nfa;
+	for (int i = 0; i != 3; ++i)
+	{
+		nfa.generateState();
+	}
+	nfa.addTransition(0, 1, static_cast<HRegexByte>('a'));
+	nfa.addTransition(0, 2, static_cast<HRegexByte>('b'));
+	nfa.setStart(0);
+	nfa.setTerminate(1, 7);
+	nfa.setTerminate(2, 9);
+	Automata dfa = Simplifier::MinimizeDFA(Simplifier::NFAToDFA(nfa, SymbolClasses(nfa)));
+	ASSERT_EQUAL(3, dfa.size());
+	DenseDFA dense(dfa);
+	auto labels = dense.getLabels(dense.next(dense.getStart(), 'a'));
+	ASSERT_EQUAL(1, labels.size());
+	ASSERT(labels.contains(7));
+	labels = dense.getLabels(dense.next(dense.getStart(), 'b'));
+	ASSERT_EQUAL(1, labels.size());
+	ASSERT(labels.contains(9));
+	// same label : merged
+	Automata unlabelled = nfa;
+	unlabelled.setTerminate(1, 9);
+	unlabelled.setTerminate(2, 7);
+	dfa = Simplifier::MinimizeDFA(Simplifier::NFAToDFA(unlabelled, SymbolClasses(unlabelled)));
+	ASSERT_EQUAL(2, dfa.size());
+}
+
+void testMinimizeOverlappingEdges()
+{
+	// equivalent states whose edges split the alphabet differently :
+	// 'a' + [b-z] from 0, [a-z] from 2
+	Automata dfa;
+	for (int i = 0; i != 4; ++i)
+	{
+		dfa.generateState();
+	}
+	RangeSet tail;
+	tail.insert(Range{ 'b', 'z' });
+	RangeSet all;
+	all.insert(Range{ 'a', 'z' });
+	dfa.addTransition(0, 1, static_cast<HRegexByte>('a'));
+	dfa.addTransition(0, 3, Transition(tail));
+	dfa.addTransition(1, 2, static_cast<HRegexByte>('1'));
+	dfa.addTransition(2, 3, Transition(all));
+	dfa.addTransition(3, 2, static_cast<HRegexByte>('1'));
+	dfa.setStart(0);
+	dfa.setTerminate(1);
+	dfa.setTerminate(3);
+	Automata minimized = Simplifier::MinimizeDFA(dfa);
+	// {0, 2} and {1, 3}
+	ASSERT_EQUAL(2, minimized.size());
+	const char* texts[] = { "a", "q", "a0a", "a1z1a", "a0", "1", "" };
+	for (auto t : texts)
+	{
+		ASSERT_EQUAL(dfa.simulate<ASCII>(t, strlen(t)), minimized.simulate<ASCII>(t, strlen(t)));
+	}
+
+	// the states after the first character and after the others
+	Automata any;
+	Parser<ASCII>("(.*)|a", any);
+	ASSERT_EQUAL(1, Simplifier::MinimizeDFA(Simplifier::NFAToDFA(any)).size());
+}
+
+void testMinimizers()
+{
+	const char* patterns[] = { "(a|b)*abb", "a?bc", "(ab|cd|ef)*(\\d\\d|x+){2,5}", "(a|b)*a(a|b){3}", ".*(a|b)" };
+	const char* texts[] = { "abb", "babb", "bc", "abc", "ab11", "cdx12", "aaba", "bbbb", "zzb", "" };
+	for (auto p : patterns)
+	{
+		Automata nfa;
+		Parser<ASCII>(p, nfa);
+		Automata dfa = Simplifier::NFAToDFA(nfa);
+		Automata hopcroft = Simplifier::Minimize(dfa, Simplifier::HOPCROFT);
+		Automata valmari = Simplifier::Minimize(dfa, Simplifier::VALMARI);
+		Automata brzozowski = Simplifier::Minimize(dfa, Simplifier::BRZOZOWSKI);
+		// no state without a way to a terminate state : all the same size
+		ASSERT_EQUAL(hopcroft.size(), valmari.size());
+		ASSERT_EQUAL(hopcroft.size(), brzozowski.size());
+		for (auto t : texts)
+		{
+			bool expected = nfa.simulate<ASCII>(t, strlen(t));
+			ASSERT_EQUAL(expected, hopcroft.simulate<ASCII>(t, strlen(t)));
+			ASSERT_EQUAL(expected, valmari.simulate<ASCII>(t, strlen(t)));
+			ASSERT_EQUAL(expected, brzozowski.simulate<ASCII>(t, strlen(t)));
+		}
+	}
+	ASSERT_EQUAL(0, Simplifier::ValmariMinimize(Automata()).size());
+	ASSERT_EQUAL(0, Simplifier::BrzozowskiMinimize(Automata()).size());
+
+	// labels : Brzozowski cannot tell them apart
+	Automata labelled;
+	for (int i = 0; i != 3; ++i)
+	{
+		labelled.generateState();
+	}
+	labelled.addTransition(0, 1, static_cast<HRegexByte>('a'));
+	labelled.addTransition(0, 2, static_cast<HRegexByte>('b'));
+	labelled.setStart(0);
+	labelled.setTerminate(1, 7);
+	labelled.setTerminate(2, 9);
+	ASSERT_EQUAL(3, Simplifier::ValmariMinimize(labelled).size());
+	ASSERT_THROWS(Simplifier::BrzozowskiMinimize(labelled), IllegalStateError);
+	labelled.setTerminate(1, 9);
+	labelled.setTerminate(2, 7);
+	ASSERT_EQUAL(2, Simplifier::BrzozowskiMinimize(labelled).size());
+	ASSERT(Simplifier::BrzozowskiMinimize(labelled).getLabels(1).contains(7));
+
+	// small or partial : Valmari & Lehtinen, large, wide and complete :
+	// Hopcroft
+	ASSERT_EQUAL(Simplifier::VALMARI, Simplifier::ChooseMinimizer(labelled));
+	Automata complete;
+	for (int i = 0; i != 2100; ++i)
+	{
+		complete.generateState();
+	}
+	for (int i = 0; i != 2100; ++i)
+	{
+		for (HRegexByte c = 'A'; c != 'A' + 32; ++c)
+		{
+			complete.addTransition(i, (i * 7 + c) % 2100, c);
+		}
+	}
+	complete.setStart(0);
+	complete.setTerminate(0);
+	ASSERT_EQUAL(Simplifier::HOPCROFT, Simplifier::ChooseMinimizer(complete));
+}
+
 // Test suits
 
 void simplifierSuit()
 {
 	cute::suite s;
 	s += CUTE(testNFAToDFA);
+	s += CUTE(testNFAToDFAOverlapping);
 	s += CUTE(testMinimizeDFA);
+	s += CUTE(testClassNFAToDFA);
+	s += CUTE(testStateSetPolicies);
+	s += CUTE(testReverseDFA);
+	s += CUTE(testMinimizeKeepsLabels);
+	s += CUTE(testMinimizeOverlappingEdges);
+	s += CUTE(testMinimizers);
 	cute::runner<cute::ostream_listener>()(s, "Simplifier Test");
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+/************************************************************************/
+/*  Test tagged DFA
+/************************************************************************/
+
+#include "tdfa.h"
+#include "pikevm.h"
+#include "cute/cute.h"
+
+void testTaggedCaptures()
+{
+	std::vector<size_t> caps;
+	// not one-pass : both branches start with a
+	TaggedDFA alternate("(a|ab)(c|bcd)(d*)");
+	ASSERT_EQUAL(4, alternate.getGroupCount());
+	ASSERT(alternate.match("abcd", 4, caps));
+	ASSERT_EQUAL(0, caps[2]);
+	ASSERT_EQUAL(1, caps[3]);
+	ASSERT_EQUAL(1, caps[4]);
+	ASSERT_EQUAL(4, caps[5]);
+	ASSERT_EQUAL(4, caps[6]);
+	ASSERT_EQUAL(4, caps[7]);
+	ASSERT(alternate.match("abcdd", 5, caps));
+	ASSERT_EQUAL(1, caps[3]);
+	ASSERT_EQUAL(4, caps[5]);
+	ASSERT_EQUAL(5, caps[7]);
+	ASSERT(!alternate.match("abd", 3, caps));
+
+	// the first group is greedy
+	TaggedDFA split("(a*)(a*)");
+	ASSERT(split.match("aaa", 3, caps));
+	ASSERT_EQUAL(3, caps[3]);
+	ASSERT_EQUAL(3, caps[4]);
+	ASSERT_EQUAL(3, caps[5]);
+
+	// fields of a log line, the key is found by the last =
+	TaggedDFA field("(.*)=(\\d+)");
+	ASSERT(field.match("a=b=42", 6, caps));
+	ASSERT_EQUAL(0, caps[2]);
+	ASSERT_EQUAL(3, caps[3]);
+	ASSERT_EQUAL(4, caps[4]);
+	ASSERT_EQUAL(6, caps[5]);
+
+	// a group that did not take part is unset
+	TaggedDFA either("(a)|(b)|(ab)");
+	ASSERT(either.match("ab", 2, caps));
+	ASSERT_EQUAL(TaggedDFA::NONE, caps[2]);
+	ASSERT_EQUAL(TaggedDFA::NONE, caps[4]);
+	ASSERT_EQUAL(0, caps[6]);
+	ASSERT_EQUAL(2, caps[7]);
+}
+
+void testTaggedAgreesWithPikeVM()
+{
+	const char* patterns[] = {
+		"(a|ab)(c|bcd)(d*)", "(a*)(a*)", "(a*)*b", "((a)|b)+", "(.*)=(\\d+)",
+		"(a+|b+)*c", "x(\xe7\x99\xbe+)(.?)", "((ab)*|a)(b?)", "(a{1,3})(a{2})"
+	};
+	const char* texts[] = {
+		"", "a", "b", "ab", "aab", "abab", "abcd", "abcdd", "aaaaa",
+		"abbac", "x=1=22", "x\xe7\x99\xbe\xe7\x99\xbez", "aba", "abb"
+	};
+	std::vector<size_t> expected;
+	std::vector<size_t> actual;
+	for (auto p : patterns)
+	{
+		TaggedDFA dfa(p);
+		PikeVM vm(p);
+		for (auto t : texts)
+		{
+			size_t len = strlen(t);
+			bool matched = vm.match(t, len, expected);
+			ASSERT_EQUAL(matched, dfa.match(t, len, actual));
+			if (matched)
+			{
+				ASSERT_EQUAL(expected, actual);
+			}
+		}
+	}
+}
+
+void testTaggedMinimize()
+{
+	// the same operations ahead, both states lead to the same row
+	TaggedDFA dfa("(a|b)*c");
+	ASSERT(dfa.size() <= 4);
+	ASSERT_THROWS(TaggedDFA("(a|b)*a(a|b){12}", 100), TooManyStatesError);
+	// dead, start and one state per letter
+	TaggedDFA("abc", 5);
+	ASSERT_THROWS(TaggedDFA("abc", 4), TooManyStatesError);
+}
+
+// Test suits
+
+void taggedDFASuit()
+{
+	cute::suite s;
+	s += CUTE(testTaggedCaptures);
+	s += CUTE(testTaggedAgreesWithPikeVM);
+	s += CUTE(testTaggedMinimize);
+	cute::runner<cute::ostream_listener>()(s, "Tagged DFA Test");
+}
\ No newline at end of file
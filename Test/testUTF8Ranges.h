@@ -0,0 +1,115 @@
+/************************************************************************/
+/*  Test UTF-8 Byte Ranges
+/************************************************************************/
+
+#include "parser.h"
+#include "simplifier.h"
+#include "densedfa.h"
+#include "utf8ranges.h"
+#include "cute/cute.h"
+
+bool sequenceEqual(const UTF8Sequence& seq, const std::vector<Range>& expected)
+{
+	if (seq.length != expected.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i != seq.length; ++i)
+	{
+		if (!(seq.bytes[i] == expected[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void testSequencesAll()
+{
+	auto seqs = UTF8Ranges::Sequences(0, 0x10ffff);
+	ASSERT_EQUAL(9, seqs.size());
+	ASSERT(sequenceEqual(seqs[0], { { 0x00, 0x7f } }));
+	ASSERT(sequenceEqual(seqs[1], { { 0xc2, 0xdf }, { 0x80, 0xbf } }));
+	ASSERT(sequenceEqual(seqs[2], { { 0xe0, 0xe0 }, { 0xa0, 0xbf }, { 0x80, 0xbf } }));
+	ASSERT(sequenceEqual(seqs[3], { { 0xe1, 0xec }, { 0x80, 0xbf }, { 0x80, 0xbf } }));
+	ASSERT(sequenceEqual(seqs[4], { { 0xed, 0xed }, { 0x80, 0x9f }, { 0x80, 0xbf } }));
+	ASSERT(sequenceEqual(seqs[5], { { 0xee, 0xef }, { 0x80, 0xbf }, { 0x80, 0xbf } }));
+	ASSERT(sequenceEqual(seqs[6], { { 0xf0, 0xf0 }, { 0x90, 0xbf }, { 0x80, 0xbf }, { 0x80, 0xbf } }));
+	ASSERT(sequenceEqual(seqs[7], { { 0xf1, 0xf3 }, { 0x80, 0xbf }, { 0x80, 0xbf }, { 0x80, 0xbf } }));
+	ASSERT(sequenceEqual(seqs[8], { { 0xf4, 0xf4 }, { 0x80, 0x8f }, { 0x80, 0xbf }, { 0x80, 0xbf } }));
+}
+
+void testSequencesSmall()
+{
+	auto seqs = UTF8Ranges::Sequences('a', 'z');
+	ASSERT_EQUAL(1, seqs.size());
+	ASSERT(sequenceEqual(seqs[0], { { 'a', 'z' } }));
+	// U+516B
+	seqs = UTF8Ranges::Sequences(0x516b, 0x516b);
+	ASSERT_EQUAL(1, seqs.size());
+	ASSERT(sequenceEqual(seqs[0], { { 0xe5, 0xe5 }, { 0x85, 0x85 }, { 0xab, 0xab } }));
+	// crosses a continuation byte boundary
+	seqs = UTF8Ranges::Sequences(0x7f0, 0x810);
+	ASSERT_EQUAL(2, seqs.size());
+	ASSERT(sequenceEqual(seqs[0], { { 0xdf, 0xdf }, { 0xb0, 0xbf } }));
+	ASSERT(sequenceEqual(seqs[1], { { 0xe0, 0xe0 }, { 0xa0, 0xa0 }, { 0x80, 0x90 } }));
+	// surrogates only
+	ASSERT_EQUAL(0, UTF8Ranges::Sequences(0xd800, 0xdfff).size());
+}
+
+Automata compileBytes(const char* pattern)
+{
+	Automata a;
+	Parser<UTF8>(pattern, a);
+	a = UTF8Ranges::CompileToBytes(a);
+	a = Simplifier::NFAToDFA(a);
+	return Simplifier::MinimizeDFA(a);
+}
+
+void testCompileToBytes()
+{
+	// U+516B+ U+767E U+4E07
+	DenseDFA dfa(compileBytes("\xe5\x85\xab+\xe7\x99\xbe\xe4\xb8\x87"));
+	ASSERT(dfa.match<RAW>("\xe5\x85\xab\xe7\x99\xbe\xe4\xb8\x87", 9));
+	ASSERT(dfa.match<RAW>("\xe5\x85\xab\xe5\x85\xab\xe7\x99\xbe\xe4\xb8\x87", 12));
+	ASSERT(!dfa.match<RAW>("\xe7\x99\xbe\xe4\xb8\x87", 6));
+	// truncated input
+	ASSERT(!dfa.match<RAW>("\xe5\x85\xab\xe7\x99\xbe\xe4\xb8", 8));
+}
+
+void testCompileWildcardToBytes()
+{
+	DenseDFA dfa(compileBytes("a.b"));
+	ASSERT(dfa.match<RAW>("axb", 3));
+	ASSERT(dfa.match<RAW>("a\xc3\xa9" "b", 4));
+	ASSERT(dfa.match<RAW>("a\xe4\xb8\x87" "b", 5));
+	ASSERT(dfa.match<RAW>("a\xf0\x9f\x98\x80" "b", 6));
+	// a NUL byte is an ordinary character
+	ASSERT(dfa.match<RAW>("a\0b", 3));
+	// invalid or overlong encodings are rejected
+	ASSERT(!dfa.match<RAW>("a\xff" "b", 3));
+	ASSERT(!dfa.match<RAW>("a\xc0\x80" "b", 4));
+	ASSERT(!dfa.match<RAW>("a\xed\xa0\x80" "b", 5));
+	ASSERT(!dfa.match<RAW>("a\xe4\xb8" "b", 4));
+}
+
+void testCompileRangeToBytes()
+{
+	DenseDFA dfa(compileBytes("\\d+"));
+	ASSERT(dfa.match<RAW>("0123456789", 10));
+	ASSERT(!dfa.match<RAW>("12a", 3));
+	ASSERT(!dfa.match<RAW>("", 0));
+}
+
+// Test suits
+
+void utf8RangesSuit()
+{
+	cute::suite s;
+	s += CUTE(testSequencesAll);
+	s += CUTE(testSequencesSmall);
+	s += CUTE(testCompileToBytes);
+	s += CUTE(testCompileWildcardToBytes);
+	s += CUTE(testCompileRangeToBytes);
+	cute::runner<cute::ostream_listener>()(s, "UTF-8 Ranges Test");
+}
\ No newline at end of file